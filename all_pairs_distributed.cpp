@@ -1,10 +1,13 @@
 #include "lib/distributed_utils.h"
+#include "lib/graph_format.h"
 
 /**
  * @brief Distributed implementation of the All-Pairs shortest path 
- *        algorithm. The executable takes one parameter (--inputFile)
- *        and returns a matrix of the shortest path's weights to get from
- *        one vertex to the next. 
+ *        algorithm. The executable takes six parameters (--inputFile,
+ *        --outputFile, --outputFormat, --checkpointFile, --checkpointInterval,
+ *        --resume) and returns a matrix of the shortest path's weights to get
+ *        from one vertex to the next. Every process checkpoints its own
+ *        block and --resume restarts all of them from the last common pivot.
  * 
  *        Number of processes is handled by MPI, thus is not an argument
  *        used in this program.
@@ -21,32 +24,83 @@ int main(int argc, char *argv[]) {
             {"inputFile", "Input graph file path",
             cxxopts::value<std::string>()->default_value(
                 "./inputs/graph.txt")},
+            {"outputFile", "Write the result to this file instead of printing it",
+            cxxopts::value<std::string>()->default_value("")},
+            {"outputFormat", "Format of the --outputFile (text, binary)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_OUTPUT_FORMAT)},
+            {"checkpointFile", "Checkpoint every block to <checkpointFile>.rank<r> while running",
+            cxxopts::value<std::string>()->default_value("")},
+            {"checkpointInterval", "Pivots between two checkpoints",
+            cxxopts::value<int>()->default_value(DEFAULT_CHECKPOINT_INTERVAL)},
+            {"resume", "Start from the newest checkpoint in --checkpointFile",
+            cxxopts::value<bool>()->default_value("false")},
         }
     );
 
     auto cl_options = options.parse(argc, argv);
     std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    std::string output_file = cl_options["outputFile"].as<std::string>();
+    std::string output_format = cl_options["outputFormat"].as<std::string>();
+    CheckpointOptions checkpoint;
+    checkpoint.path = cl_options["checkpointFile"].as<std::string>();
+    checkpoint.interval = cl_options["checkpointInterval"].as<int>();
+    checkpoint.resume = cl_options["resume"].as<bool>();
 
-    // parse the input file
-    std::ifstream inputFile(input_file_path); 
-    if (!inputFile.is_open()) { // Check if the file opened successfully
+    if (!is_output_format(output_format)) {
+        std::cout << "Unknown output format (" << output_format << ")" << std::endl;
+        return 1;
+    }
+    if (output_format == "binary" && output_file.empty()) {
+        std::cout << "--outputFormat binary needs an --outputFile" << std::endl;
+        return 1;
+    }
+    if (checkpoint.interval <= 0) {
+        std::cout << "Checkpoint interval must be positive" << std::endl;
+        return 1;
+    }
+    if (checkpoint.resume && !checkpoint.enabled()) {
+        std::cout << "--resume needs a --checkpointFile" << std::endl;
+        return 1;
+    }
+
+    // map the input file, a binary graph is used in place and from a text
+    // graph every rank only parses the lines of its own rows
+    std::shared_ptr<MappedFile> inputFile = std::make_shared<MappedFile>(input_file_path);
+    if (!inputFile->is_open()) { // Check if the file opened successfully
         std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
         return 1;
     }
+    if (checkpoint.enabled()) {
+        checkpoint.fingerprint = input_fingerprint(inputFile->data(), inputFile->size());
+    }
 
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(inputFile, line)) {
-        if (!line.empty()) { lines.push_back(line); }
+    CSRGraph graph;
+    std::vector<LineSpan> lines;
+    int n;
+    std::function<bool(Matrix_2D*, GridBlock&)> init_block;
+    if (is_binary_graph(inputFile->data(), inputFile->size())) {
+        std::string error;
+        if (!read_binary_graph(inputFile, false, graph, error)) {
+            std::cout << error << " (" << input_file_path << ")" << std::endl;
+            return 1;
+        }
+        n = graph.get_n_vertices();
+        init_block = [&](Matrix_2D* distances, GridBlock& block) {
+            return block_init(distances, block, graph);
+        };
+    } else {
+        lines = find_lines(inputFile->data(), inputFile->size(), 1);
+        n = lines.size();
+        init_block = [&](Matrix_2D* distances, GridBlock& block) {
+            return block_init(distances, block, inputFile->data(), lines);
+        };
     }
 
-    if (lines.size() == 0) {
+    if (n == 0) {
         std::cout << "Empty Input Graph!" << std::endl;
 
-    } else if (!all_pairs_distributed(lines)) {
+    } else if (!all_pairs_distributed(n, init_block, output_file, output_format, checkpoint)) {
         std::cout << "Something went wrong!" << std::endl;
     }
-
-    inputFile.close(); // Close the file
     return 0;
 }
\ No newline at end of file
@@ -1,11 +1,17 @@
+#include "lib/graph_format.h"
 #include "lib/parallel_utils.h"
 
 
 /**
  * @brief Parallel implementation of the All-Pairs shortest path 
- *        algorithm. The executable takes two parameter (--inputFile, --nThreads)
- *        and returns a matrix of the shortest path's wieghts to get from
- *        one vertex to the next. 
+ *        algorithm. The executable takes thirteen parameters (--inputFile,
+ *        --nThreads, --engine, --tileSize, --barrier, --affinity, --cpuList,
+ *        --outputFile, --outputFormat, --paths, --checkpointFile,
+ *        --checkpointInterval, --resume)
+ *        and returns a matrix of the shortest path's wieghts to get from one
+ *        vertex to the next. --engine auto picks the engine with the cost
+ *        model of select_engine. The Floyd-Warshall engines checkpoint the
+ *        matrix to --checkpointFile and --resume restarts from it.
  * 
  */
 int main(int argc, char *argv[]) {
@@ -24,34 +30,157 @@ int main(int argc, char *argv[]) {
             {
                 "inputFile", "Input graph file path",
                 cxxopts::value<std::string>()->default_value("./inputs/graph.txt")
+            },
+            {
+                "engine", "Parallel engine (copy, inplace, blocked, dijkstra, dial, scc, auto)",
+                cxxopts::value<std::string>()->default_value(DEFAULT_PARALLEL_ENGINE)
+            },
+            {
+                "tileSize", "Tile size used by the blocked and scc engines",
+                cxxopts::value<int>()->default_value(DEFAULT_TILE_SIZE)
+            },
+            {
+                "barrier", "Barrier used by the copy and inplace engines (blocking, spin, tournament)",
+                cxxopts::value<std::string>()->default_value(DEFAULT_BARRIER)
+            },
+            {
+                "affinity", "Thread pinning (none, compact, scatter, list)",
+                cxxopts::value<std::string>()->default_value(DEFAULT_AFFINITY)
+            },
+            {
+                "cpuList", "Comma separated CPUs used by --affinity list",
+                cxxopts::value<std::string>()->default_value("")
+            },
+            {
+                "outputFile", "Write the result to this file instead of printing it",
+                cxxopts::value<std::string>()->default_value("")
+            },
+            {
+                "outputFormat", "Format of the --outputFile (text, binary)",
+                cxxopts::value<std::string>()->default_value(DEFAULT_OUTPUT_FORMAT)
+            },
+            {
+                "paths", "Also compute the next hop of every shortest path",
+                cxxopts::value<bool>()->default_value("false")
+            },
+            {
+                "checkpointFile", "Checkpoint the matrix to this file while the engine runs",
+                cxxopts::value<std::string>()->default_value("")
+            },
+            {
+                "checkpointInterval", "Pivots between two checkpoints",
+                cxxopts::value<int>()->default_value(DEFAULT_CHECKPOINT_INTERVAL)
+            },
+            {
+                "resume", "Start from the newest checkpoint in --checkpointFile",
+                cxxopts::value<bool>()->default_value("false")
             }
         }
     );
 
     auto cl_options = options.parse(argc, argv);
     std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    std::string output_file = cl_options["outputFile"].as<std::string>();
+    std::string output_format = cl_options["outputFormat"].as<std::string>();
+    bool paths = cl_options["paths"].as<bool>();
     uint n_threads = cl_options["nThreads"].as<uint>();
-    
-    // parse the input file
-    std::ifstream inputFile(input_file_path); 
-    if (!inputFile.is_open()) { // Check if the file opened successfully
+    std::string engine = cl_options["engine"].as<std::string>();
+    int tile_size = cl_options["tileSize"].as<int>();
+    std::string barrier_kind = cl_options["barrier"].as<std::string>();
+    std::string affinity = cl_options["affinity"].as<std::string>();
+    std::string cpu_list = cl_options["cpuList"].as<std::string>();
+    CheckpointOptions checkpoint;
+    checkpoint.path = cl_options["checkpointFile"].as<std::string>();
+    checkpoint.interval = cl_options["checkpointInterval"].as<int>();
+    checkpoint.resume = cl_options["resume"].as<bool>();
+
+    if (!is_parallel_engine(engine) && engine != "auto") {
+        std::cout << "Unknown engine (" << engine << ")" << std::endl;
+        return 1;
+    }
+    if (!is_barrier_kind(barrier_kind)) {
+        std::cout << "Unknown barrier (" << barrier_kind << ")" << std::endl;
+        return 1;
+    }
+    if (!is_affinity_kind(affinity)) {
+        std::cout << "Unknown affinity (" << affinity << ")" << std::endl;
+        return 1;
+    }
+    if (affinity == "list" && cpu_list.empty()) {
+        std::cout << "--affinity list needs a --cpuList" << std::endl;
+        return 1;
+    }
+    std::vector<int> parsed_cpus;
+    if (!parse_cpu_list(cpu_list, parsed_cpus) || (affinity == "list" && parsed_cpus.empty())) {
+        std::cout << "Invalid --cpuList (" << cpu_list << ")" << std::endl;
+        return 1;
+    }
+    if (tile_size <= 0) {
+        std::cout << "Tile size must be positive" << std::endl;
+        return 1;
+    }
+    if (!is_output_format(output_format)) {
+        std::cout << "Unknown output format (" << output_format << ")" << std::endl;
+        return 1;
+    }
+    if (output_format == "binary" && output_file.empty()) {
+        std::cout << "--outputFormat binary needs an --outputFile" << std::endl;
+        return 1;
+    }
+    if (paths && !engine_supports_paths(engine) && engine != "auto") {
+        std::cout << "--paths needs the inplace, blocked, dijkstra, dial or scc engine" << std::endl;
+        return 1;
+    }
+    if (checkpoint.interval <= 0) {
+        std::cout << "Checkpoint interval must be positive" << std::endl;
+        return 1;
+    }
+    if (checkpoint.resume && !checkpoint.enabled()) {
+        std::cout << "--resume needs a --checkpointFile" << std::endl;
+        return 1;
+    }
+
+    // map the input file, a binary graph is used in place and a text graph
+    // is parsed by n_threads threads
+    std::shared_ptr<MappedFile> inputFile = std::make_shared<MappedFile>(input_file_path);
+    if (!inputFile->is_open()) { // Check if the file opened successfully
         std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
         return 1;
     }
 
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(inputFile, line)) {
-        if (!line.empty()) { lines.push_back(line); }
+    CSRGraph graph;
+    std::string error;
+    if (!load_graph(inputFile, n_threads, graph, error)) {
+        std::cout << error << " (" << input_file_path << ")" << std::endl;
+        return 1;
     }
 
-    if (lines.size() == 0) {
+    if (graph.get_n_vertices() == 0) {
         std::cout << "Empty Input Graph!" << std::endl;
+        return 0;
+    }
 
-    }else if (!all_pairs_parallel(lines, n_threads)) {
+    // auto picks the engine from the shape of the graph and the threads, the
+    // decision is logged after the timing
+    EngineChoice choice;
+    if (engine == "auto") {
+        choice = select_engine(graph, n_threads, paths);
+        engine = choice.engine;
+    }
+    if (checkpoint.enabled()) {
+        // single source and scc engines have no pivot to restart from
+        if (is_sssp_engine(engine) || engine == "scc") {
+            std::cout << "--checkpointFile needs the copy, inplace or blocked engine" << std::endl;
+            return 1;
+        }
+        checkpoint.fingerprint = input_fingerprint(inputFile->data(), inputFile->size());
+    }
+    if (!all_pairs_parallel(
+        graph, n_threads, engine, tile_size, barrier_kind,
+        affinity_cpus(affinity, cpu_list, n_threads), output_file, output_format, paths,
+        checkpoint)) {
         std::cout << "Something went wrong!" << std::endl;
     }
-
-    inputFile.close(); // Close the file
+    if (!choice.engine.empty()) { std::cout << describe_engine_choice(choice) << std::endl; }
     return 0;
 }
\ No newline at end of file
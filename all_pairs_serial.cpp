@@ -1,11 +1,15 @@
+#include "lib/graph_format.h"
 #include "lib/serial_utils.h"
 
 
 /**
  * @brief Serial implementation of the All-Pairs shortest path 
- *        algorithm. The executable takes one parameter (--inputFile)
- *        and returns a matrix of the shortest path's wieghts to get from
- *        one vertex to the next. 
+ *        algorithm. The executable takes six parameters (--inputFile,
+ *        --engine, --tileSize, --outputFile, --outputFormat, --paths) and
+ *        returns a matrix of the shortest path's wieghts to get from one
+ *        vertex to the next. With --paths it also returns the next hop of
+ *        every shortest path. --engine auto picks the engine with the cost
+ *        model of select_engine.
  * 
  */
 int main(int argc, char *argv[]) {
@@ -20,32 +24,75 @@ int main(int argc, char *argv[]) {
             {"inputFile", "Input graph file path",
             cxxopts::value<std::string>()->default_value(
                 "./inputs/graph.txt")},
+            {"engine", "Shortest path engine (naive, blocked, dijkstra, dial, scc, auto)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_ENGINE)},
+            {"tileSize", "Tile size used by the blocked and scc engines",
+            cxxopts::value<int>()->default_value(DEFAULT_TILE_SIZE)},
+            {"outputFile", "Write the result to this file instead of printing it",
+            cxxopts::value<std::string>()->default_value("")},
+            {"outputFormat", "Format of the --outputFile (text, binary)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_OUTPUT_FORMAT)},
+            {"paths", "Also compute the next hop of every shortest path",
+            cxxopts::value<bool>()->default_value("false")},
         }
     );
 
     auto cl_options = options.parse(argc, argv);
     std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    std::string output_file = cl_options["outputFile"].as<std::string>();
+    std::string output_format = cl_options["outputFormat"].as<std::string>();
+    bool paths = cl_options["paths"].as<bool>();
+    std::string engine = cl_options["engine"].as<std::string>();
+    int tile_size = cl_options["tileSize"].as<int>();
 
-    // parse the input file
-    std::ifstream inputFile(input_file_path); 
-    if (!inputFile.is_open()) { // Check if the file opened successfully
+    if (!is_serial_engine(engine) && engine != "auto") {
+        std::cout << "Unknown engine (" << engine << ")" << std::endl;
+        return 1;
+    }
+    if (tile_size <= 0) {
+        std::cout << "Tile size must be positive" << std::endl;
+        return 1;
+    }
+
+    if (!is_output_format(output_format)) {
+        std::cout << "Unknown output format (" << output_format << ")" << std::endl;
+        return 1;
+    }
+    if (output_format == "binary" && output_file.empty()) {
+        std::cout << "--outputFormat binary needs an --outputFile" << std::endl;
+        return 1;
+    }
+
+    // map the input file, a binary graph is used in place and a text graph
+    // is parsed on every core
+    std::shared_ptr<MappedFile> inputFile = std::make_shared<MappedFile>(input_file_path);
+    if (!inputFile->is_open()) { // Check if the file opened successfully
         std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
         return 1;
     }
 
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(inputFile, line)) {
-        if (!line.empty()) { lines.push_back(line); }
+    CSRGraph graph;
+    std::string error;
+    if (!load_graph(inputFile, ingest_threads(), graph, error)) {
+        std::cout << error << " (" << input_file_path << ")" << std::endl;
+        return 1;
     }
 
-    if (lines.size() == 0) {
+    if (graph.get_n_vertices() == 0) {
         std::cout << "Empty Input Graph!" << std::endl;
+        return 0;
+    }
 
-    }else if (!all_pairs_serial(lines)) {
+    // auto picks the engine from the shape of the graph, the decision is
+    // logged after the timing
+    EngineChoice choice;
+    if (engine == "auto") {
+        choice = select_engine(graph, 1, paths);
+        engine = choice.engine;
+    }
+    if (!all_pairs_serial(graph, engine, tile_size, output_file, output_format, paths)) {
         std::cout << "Something went wrong!" << std::endl;
     }
-
-    inputFile.close(); // Close the file
+    if (!choice.engine.empty()) { std::cout << describe_engine_choice(choice) << std::endl; }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "core/core_utils.h"
+#include "lib/matrix_output.h"
+#include "lib/query_server.h"
+
+
+/**
+ * @brief Serve distance queries from a distance matrix written by an
+ *        all_pairs binary with --outputFormat binary, without computing it
+ *        again. The executable takes five parameters (--matrixFile, --socket,
+ *        --nThreads, --protocol, --preload). Queries are read from stdin, or
+ *        from the connections to a Unix domain socket with --socket, see
+ *        QueryServer for the protocols. The query count and the p50 and p99
+ *        latencies are reported on stderr when the server stops.
+ */
+int main(int argc, char *argv[]) {
+    cxxopts::Options options(
+        "apsp serve",
+        "Answer shortest path distance queries from a precomputed matrix"
+    );
+    options.add_options(
+        "",
+        {
+            {"matrixFile", "Binary distance matrix written with --outputFormat binary",
+            cxxopts::value<std::string>()->default_value(
+                "./outputs/distances.bin")},
+            {"socket", "Unix domain socket path, queries are read from stdin without one",
+            cxxopts::value<std::string>()->default_value("")},
+            {"nThreads", "Number of threads reading from the socket connections",
+            cxxopts::value<int>()->default_value(DEFAULT_SERVER_THREADS)},
+            {"protocol", "Query protocol (line, binary)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_PROTOCOL)},
+            {"preload", "Load every page of the matrix before serving",
+            cxxopts::value<bool>()->default_value("true")},
+        }
+    );
+
+    auto cl_options = options.parse(argc, argv);
+    std::string matrix_file_path = cl_options["matrixFile"].as<std::string>();
+    std::string socket_path = cl_options["socket"].as<std::string>();
+    int n_threads = cl_options["nThreads"].as<int>();
+    std::string protocol = cl_options["protocol"].as<std::string>();
+    bool preload = cl_options["preload"].as<bool>();
+
+    if (!is_query_protocol(protocol)) {
+        std::cout << "Unknown protocol (" << protocol << ")" << std::endl;
+        return 1;
+    }
+    if (n_threads <= 0) {
+        std::cout << "Number of threads must be positive" << std::endl;
+        return 1;
+    }
+
+    MappedMatrix matrix;
+    std::string error;
+    if (!map_binary_matrix(matrix_file_path, matrix, error)) {
+        std::cout << error << std::endl;
+        return 1;
+    }
+    if (matrix.header.element_bytes != sizeof(int32_t)) {
+        std::cout << "Not a distance matrix (" << matrix_file_path << ")" << std::endl;
+        return 1;
+    }
+
+    // fault the pages in now rather than during the first queries
+    if (preload) {
+        volatile char touched = 0;
+        for (size_t offset = 0; offset < matrix.file->size(); offset += 4096) {
+            touched = touched + matrix.file->data()[offset];
+        }
+    }
+
+    // stdout carries the replies in stdin mode, so the log goes to stderr
+    QueryServer server(matrix, socket_path.empty() ? 1 : n_threads);
+    bool served;
+    if (socket_path.empty()) {
+        served = server.serve_stream(0, 1, protocol == "binary", 0);
+    } else {
+#ifdef _WIN32
+        std::cout << "--socket is not supported on Windows" << std::endl;
+        return 1;
+#else
+        std::cerr << "Serving a " << matrix.header.rows << " x " << matrix.header.columns
+                  << " matrix on " << socket_path << std::endl;
+        served = serve_socket(server, socket_path, n_threads, protocol == "binary");
+        if (!served) {
+            std::cout << "Unable to listen on socket (" << socket_path << ")" << std::endl;
+            return 1;
+        }
+#endif
+    }
+    std::cerr << server.stats() << std::endl;
+    return served ? 0 : 1;
+}
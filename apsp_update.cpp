@@ -0,0 +1,148 @@
+#include "core/core_utils.h"
+#include "lib/dynamic_utils.h"
+#include "lib/graph_format.h"
+
+
+/**
+ * @brief Apply a batch of edge updates to a distance matrix written by an
+ *        all_pairs binary with --outputFormat binary, without recomputing it.
+ *        The executable takes six parameters (--matrixFile, --updates,
+ *        --outputFile, --inputFile, --graphOutputFile, --nThreads).
+ *        Insertions and decreases cost O(n^2) (see decrease_edge). Increases
+ *        and deletions need the graph of the matrix (--inputFile) and
+ *        recompute only the rows that used the edge (see increase_edge).
+ *        The changed entries are printed as "from,to,distance" lines, and the
+ *        updated matrix and graph are written back.
+ */
+int main(int argc, char *argv[]) {
+    std::cout << std::scientific << std::setprecision(TIME_PRECISION);
+    cxxopts::Options options(
+        "apsp update",
+        "Update a precomputed distance matrix for inserted or lowered edges"
+    );
+    options.add_options(
+        "",
+        {
+            {"matrixFile", "Binary distance matrix written with --outputFormat binary",
+            cxxopts::value<std::string>()->default_value(
+                "./outputs/distances.bin")},
+            {"updates", "Edge updates, one from,to,weight line per edge",
+            cxxopts::value<std::string>()->default_value(
+                "./inputs/updates.txt")},
+            {"outputFile", "Write the updated matrix here instead of over --matrixFile",
+            cxxopts::value<std::string>()->default_value("")},
+            {"inputFile", "Graph of the matrix, needed to raise or delete edges",
+            cxxopts::value<std::string>()->default_value("")},
+            {"graphOutputFile", "Write the updated graph here instead of over --inputFile",
+            cxxopts::value<std::string>()->default_value("")},
+            {"nThreads", "Number of threads updating the rows",
+            cxxopts::value<int>()->default_value(DEFAULT_UPDATE_THREADS)},
+        }
+    );
+
+    auto cl_options = options.parse(argc, argv);
+    std::string matrix_file_path = cl_options["matrixFile"].as<std::string>();
+    std::string updates_path = cl_options["updates"].as<std::string>();
+    std::string output_file = cl_options["outputFile"].as<std::string>();
+    std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    std::string graph_output_file = cl_options["graphOutputFile"].as<std::string>();
+    int n_threads = cl_options["nThreads"].as<int>();
+    if (output_file.empty()) { output_file = matrix_file_path; }
+    if (graph_output_file.empty()) { graph_output_file = input_file_path; }
+
+    if (n_threads <= 0) {
+        std::cout << "Number of threads must be positive" << std::endl;
+        return 1;
+    }
+
+    MappedMatrix matrix;
+    std::string error;
+    if (!map_binary_matrix(matrix_file_path, matrix, error)) {
+        std::cout << error << std::endl;
+        return 1;
+    }
+    Matrix_2D* distances = copy_mapped_matrix(matrix);
+    if (distances == NULL) {
+        std::cout << "Not a distance matrix (" << matrix_file_path << ")" << std::endl;
+        return 1;
+    }
+    // the file may be written over below, drop the mapping first
+    matrix.file.reset();
+
+    // the graph is optional, without it edges can only be inserted or lowered
+    CSRGraph graph;
+    bool binary_graph = false;
+    if (!input_file_path.empty()) {
+        std::shared_ptr<MappedFile> input_file = std::make_shared<MappedFile>(input_file_path);
+        if (!input_file->is_open()) {
+            std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
+            delete distances;
+            return 1;
+        }
+        binary_graph = is_binary_graph(input_file->data(), input_file->size());
+        if (!load_graph(input_file, n_threads, graph, error)) {
+            std::cout << error << " (" << input_file_path << ")" << std::endl;
+            delete distances;
+            return 1;
+        }
+        if (graph.get_n_vertices() != distances->get_dimension()) {
+            std::cout << "The graph and the matrix have different sizes" << std::endl;
+            delete distances;
+            return 1;
+        }
+    }
+
+    MappedFile updates_file(updates_path);
+    std::vector<EdgeUpdate> updates;
+    if (!updates_file.is_open()) {
+        std::cout << "Unable to open file (" << updates_path << ")" << std::endl;
+        delete distances;
+        return 1;
+    }
+    if (!parse_edge_updates(
+            updates_file.data(), updates_file.size(), distances->get_dimension(),
+            updates, error)) {
+        std::cout << error << " (" << updates_path << ")" << std::endl;
+        delete distances;
+        return 1;
+    }
+
+    timer update_timer;
+    update_timer.start();
+    std::vector<DistanceChange> changes;
+    int64_t rows_recomputed = 0;
+    CSRGraph loaded = graph; // keeps its storage, so a new graph has another address
+    bool applied = apply_edge_updates(
+        distances, input_file_path.empty() ? NULL : &graph, updates, n_threads,
+        short_lived_threads(n_threads), changes, rows_recomputed, error
+    );
+    double time_taken = update_timer.stop();
+
+    // the updates before a rejected one stay applied and are written
+    bool written = print_distance_changes(changes);
+    if (!write_binary_matrix(distances, output_file)) {
+        std::cout << "Unable to write file (" << output_file << ")" << std::endl;
+        written = false;
+    }
+    // an updated graph has its own storage, so the loaded one (possibly a
+    // mapping of the file) is released before the file is written over
+    bool graph_changed = graph.get_offsets() != loaded.get_offsets();
+    loaded = CSRGraph();
+    if (graph_changed) {
+        bool graph_written = binary_graph
+            ? write_binary_graph(graph_output_file, graph, error)
+            : write_text_graph(graph_output_file, graph, error);
+        if (!graph_written) {
+            std::cout << error << std::endl;
+            written = false;
+        }
+    }
+    if (!applied) { std::cout << error << std::endl; }
+    std::cout << "Updates: " << updates.size() << ", changed entries: " << changes.size()
+              << std::endl;
+    std::cout << "Rows recomputed: " << rows_recomputed << " of "
+              << distances->get_dimension() << std::endl;
+    std::cout << "Time taken: " << time_taken << std::endl;
+    delete distances;
+    return applied && written ? 0 : 1;
+}
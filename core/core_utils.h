@@ -1,3 +1,6 @@
+#ifndef CORE_UTILS_H
+#define CORE_UTILS_H
+
 #include "cxxopts.h"
 #include "get_time.h"
 #include <iomanip>
@@ -11,4 +14,6 @@
 #define TIME_PRECISION 5
 
 
-const int INFINITY_INT = std::numeric_limits<int>::max() / 2 - 1;
\ No newline at end of file
+const int INFINITY_INT = std::numeric_limits<int>::max() / 2 - 1;
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef EXCEPTIONS_H
+#define EXCEPTIONS_H
+
 #include <stdexcept>
 
 
@@ -12,4 +15,6 @@ public:
     const char* what() const noexcept override {
         return message.c_str();
     }
-};
\ No newline at end of file
+};
+
+#endif
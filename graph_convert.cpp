@@ -0,0 +1,100 @@
+#include "core/core_utils.h"
+#include "lib/graph_format.h"
+
+#define DEFAULT_GRAPH_FORMAT "binary"
+
+
+bool same_graph(const CSRGraph& a, const CSRGraph& b) {
+    if (a.get_n_vertices() != b.get_n_vertices() || a.get_n_edges() != b.get_n_edges()) {
+        return false;
+    }
+    return std::equal(a.get_offsets(), a.get_offsets() + a.get_n_vertices() + 1, b.get_offsets())
+        && std::equal(a.get_targets(), a.get_targets() + a.get_n_edges(), b.get_targets())
+        && std::equal(a.get_weights(), a.get_weights() + a.get_n_edges(), b.get_weights());
+}
+
+
+/**
+ * @brief Convert a graph between the text format of input_generator and the
+ *        binary CSR format (lib/graph_format.h). The executable takes four
+ *        parameters (--inputFile, --outputFile, --format, --verify). The input
+ *        format is detected from the file. With --verify the output is read
+ *        back, checksums included, and compared with the input graph.
+ */
+int main(int argc, char *argv[]) {
+    std::cout << std::scientific << std::setprecision(TIME_PRECISION);
+    cxxopts::Options options(
+        "graph convert",
+        "Convert a graph between the text and the binary format"
+    );
+    options.add_options(
+        "",
+        {
+            {"inputFile", "Input graph file path, text or binary",
+            cxxopts::value<std::string>()->default_value(
+                "./inputs/graph.txt")},
+            {"outputFile", "Output graph file path",
+            cxxopts::value<std::string>()->default_value(
+                "./inputs/graph.bin")},
+            {"format", "Output format (binary, text)",
+            cxxopts::value<std::string>()->default_value(DEFAULT_GRAPH_FORMAT)},
+            {"verify", "Read the output back and compare it with the input",
+            cxxopts::value<bool>()->default_value("false")},
+        }
+    );
+
+    auto cl_options = options.parse(argc, argv);
+    std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    std::string output_file_path = cl_options["outputFile"].as<std::string>();
+    std::string format = cl_options["format"].as<std::string>();
+    bool verify = cl_options["verify"].as<bool>();
+
+    if (format != "binary" && format != "text") {
+        std::cout << "Unknown format (" << format << ")" << std::endl;
+        return 1;
+    }
+
+    timer convert_timer;
+    convert_timer.start();
+
+    std::shared_ptr<MappedFile> inputFile = std::make_shared<MappedFile>(input_file_path);
+    if (!inputFile->is_open()) {
+        std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
+        return 1;
+    }
+    CSRGraph graph;
+    std::string error;
+    bool loaded = is_binary_graph(inputFile->data(), inputFile->size())
+        ? read_binary_graph(inputFile, verify, graph, error)
+        : load_graph(inputFile, ingest_threads(), graph, error);
+    if (!loaded) {
+        std::cout << error << " (" << input_file_path << ")" << std::endl;
+        return 1;
+    }
+
+    bool written = format == "binary"
+        ? write_binary_graph(output_file_path, graph, error)
+        : write_text_graph(output_file_path, graph, error);
+    if (!written) {
+        std::cout << error << std::endl;
+        return 1;
+    }
+    std::cout << "Converted " << graph.get_n_vertices() << " vertices and "
+              << graph.get_n_edges() << " edges to " << format << std::endl;
+
+    if (verify) {
+        std::shared_ptr<MappedFile> outputFile = std::make_shared<MappedFile>(output_file_path);
+        CSRGraph converted;
+        bool read = outputFile->is_open() && (format == "binary"
+            ? read_binary_graph(outputFile, true, converted, error)
+            : load_graph(outputFile, ingest_threads(), converted, error));
+        if (!read || !same_graph(graph, converted)) {
+            std::cout << "Verification failed" << (read ? "" : ": " + error) << std::endl;
+            return 1;
+        }
+        std::cout << "Verified " << output_file_path << std::endl;
+    }
+
+    std::cout << "Time taken: " << convert_timer.stop() << std::endl;
+    return 0;
+}
@@ -68,6 +68,13 @@ void generateGraph(int* n_nodes, int* n_edges, int* min_weight, int* max_weight,
             edges_for_node = *n_edges;
         }
 
+        // A node without edges still needs its own line, an empty line is dropped
+        // and would shift every later node. A self loop of weight 0 adds no path.
+        if(edges_for_node == 0){
+            output_file << current_node << ",0" << std::endl;
+            continue;
+        }
+
         // Output graph layout to file. 
         // Formatted with each node on its own line, and edges and weights alternating,
         // separated by commas. So "2,1,3,4" on line 1 means node 1 has:
@@ -1,3 +1,6 @@
+#ifndef EDGE_H
+#define EDGE_H
+
 #include <iostream>
 #include <stdlib.h>
 
@@ -39,3 +42,5 @@ public:
                edge1.weight == edge2.weight;
     }
 };
+
+#endif
@@ -1,120 +1,218 @@
+#ifndef MATRIX_2D_H
+#define MATRIX_2D_H
+
 #include "../core/exceptions.h"
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <stdlib.h>
 
+// Every row starts on a cache line boundary, so kernels can use aligned loads
+#define MATRIX_ALIGNMENT 64
+#define MATRIX_ROW_PADDING (MATRIX_ALIGNMENT / sizeof(int))
+
 
 /**
- * @brief Two dimensional int array 
- * 
+ * @brief Two dimensional int array stored as a single 64-byte aligned,
+ *        row-major allocation. Rows are padded to a multiple of the cache
+ *        line so row(i) is always aligned.
+ *
+ *        row() and at() are unchecked and meant for the hot loops. The
+ *        checked get_matrix_value/set_matrix_value API only validates its
+ *        indices when compiled with -DMATRIX_2D_DEBUG (make DEBUG_MATRIX=1).
  */
 class Matrix_2D {
 
 private:
-    int dimension;
-    int** matrix;
+    int dimension; // number of rows
+    int columns;   // equal to dimension unless the matrix is a rectangular block
+    int stride;    // row length in ints, including padding
+    int* matrix;
+
+    void allocate() {
+        this->stride = (int) (((this->columns + MATRIX_ROW_PADDING - 1)
+                              / MATRIX_ROW_PADDING) * MATRIX_ROW_PADDING);
+        size_t bytes = (size_t) this->dimension * this->stride * sizeof(int);
+        if (bytes == 0) { bytes = MATRIX_ALIGNMENT; }
+
+        void* memory = NULL;
+#ifdef _WIN32
+        memory = _aligned_malloc(bytes, MATRIX_ALIGNMENT);
+#else
+        if (posix_memalign(&memory, MATRIX_ALIGNMENT, bytes) != 0) { memory = NULL; }
+#endif
+        if (memory == NULL) { throw std::bad_alloc(); }
+        this->matrix = static_cast<int*>(memory);
+    }
 
 public:
-    Matrix_2D(int dimension, int initial_value) {
-        this->dimension = dimension;
-        this->matrix = new int*[dimension];
-        for (int i = 0; i < dimension; ++i) {
-            matrix[i] = new int[dimension];
-        }
+    Matrix_2D(int dimension, int initial_value) : Matrix_2D(dimension, dimension, initial_value) {}
 
-        // Initialize the elements of the matrix to infinity
-        for (int i = 0; i < dimension; i++) {
-            for (int j = 0; j < dimension; j++) {
-                matrix[i][j] = initial_value;
-            }
+    /**
+     * @brief Rectangular matrix, e.g. the block of the distance matrix owned
+     *        by one process of the distributed engine.
+     *
+     * @param rows Number of rows.
+     * @param columns Number of columns.
+     * @param initial_value Value of every element.
+     */
+    Matrix_2D(int rows, int columns, int initial_value) {
+        this->dimension = rows;
+        this->columns = columns;
+        allocate();
+
+        // Initialize the elements of the matrix, padding included
+        size_t size = (size_t) this->dimension * this->stride;
+        for (size_t i = 0; i < size; i++) {
+            matrix[i] = initial_value;
         }
     }
 
+    /**
+     * @brief Allocate the matrix without touching its memory. The rows are
+     *        expected to be initialized with fill_rows by the thread that will
+     *        work on them, so their pages land on that thread's NUMA node.
+     *
+     * @param dimension Dimension of the 2D matrix.
+     */
+    explicit Matrix_2D(int dimension) {
+        this->dimension = dimension;
+        this->columns = dimension;
+        allocate();
+    }
+
     ~Matrix_2D() {
-        for (int i = 0; i < this->dimension; i++) {
-            delete[] matrix[i];
-        }
-        delete[] matrix;
+#ifdef _WIN32
+        _aligned_free(matrix);
+#else
+        free(matrix);
+#endif
     }
 
+    Matrix_2D(const Matrix_2D&) = delete;
+    Matrix_2D& operator=(const Matrix_2D&) = delete;
+
     /**
      * @brief Getter method for dimension
-     * 
+     *
      * @return Dimension of the 2D matrix
      */
-    int get_dimension() { return dimension; }
-    
+    int get_dimension() const { return dimension; }
 
-    void update_matrix(Matrix_2D* new_matrix) {
-        for (int row = 0; row < this->dimension; row++) {
-            for (int column = 0; column < this->dimension; column++) {
-                this->matrix[row][column] = new_matrix->get_matrix_value(row, column);
-            }
+    /**
+     * @brief Getter method for the number of columns
+     *
+     * @return Number of columns, the dimension for a square matrix
+     */
+    int get_columns() const { return columns; }
+
+    /**
+     * @brief Getter method for the padded row length
+     *
+     * @return Number of ints between the start of two consecutive rows
+     */
+    int get_stride() const { return stride; }
+
+    /**
+     * @brief Raw pointer to the start of a row. No bounds checking.
+     *
+     * @param row Index of the matrix row.
+     * @return Pointer to the first element of the row (64-byte aligned).
+     */
+    inline int* row(int row) { return matrix + (size_t) row * stride; }
+    inline const int* row(int row) const { return matrix + (size_t) row * stride; }
+
+    /**
+     * @brief Unchecked element access for the kernels.
+     */
+    inline int& at(int row, int column) { return matrix[(size_t) row * stride + column]; }
+    inline int at(int row, int column) const { return matrix[(size_t) row * stride + column]; }
+
+    /**
+     * @brief Set every element (padding included) of rows [start_row, end_row).
+     */
+    void fill_rows(int start_row, int end_row, int value) {
+        int* first = row(start_row);
+        int* last = row(end_row);
+        for (int* element = first; element < last; element++) {
+            *element = value;
         }
     }
 
+    void update_matrix(Matrix_2D* new_matrix) {
+        std::memcpy(
+            this->matrix, new_matrix->matrix,
+            (size_t) this->dimension * this->stride * sizeof(int)
+        );
+    }
+
 
     /**
      * @brief Get the matrix value at the given index.
-     * 
+     *
      * @param row Index of the matrix row.
      * @param column Index of the matrix column.
      * @return int value of the value at the [row][column].
      */
     int get_matrix_value(int row, int column) {
-        if (row < 0 || row > this->dimension) {
+#ifdef MATRIX_2D_DEBUG
+        if (row < 0 || row >= this->dimension) {
             throw IndexOutOfBoundsException("Invalid row index: " + std::to_string(row));
-        } else if (column < 0 || column > this->dimension) {
+        } else if (column < 0 || column >= this->columns) {
             throw IndexOutOfBoundsException("Invalid column index: " + std::to_string(column));
-        } else {
-            return this->matrix[row][column];
         }
+#endif
+        return at(row, column);
     }
 
     /**
-     * @brief Update a matrix value at a given index. 
-     * 
+     * @brief Update a matrix value at a given index.
+     *
      * @param row Index of the matrix row.
      * @param column Index of the matrix column.
      * @param new_value New value to be placed into the matrix.
      * @return true if the matrix was updated successfully, false otherwise.
      */
     bool set_matrix_value(int row, int column, int new_value) {
-        if (row < 0 || row > this->dimension) {
+#ifdef MATRIX_2D_DEBUG
+        if (row < 0 || row >= this->dimension) {
             std::cerr << "Invalid row index: " << row << std::endl;
             return false;
-        } else if (column < 0 || column > this->dimension) {
+        } else if (column < 0 || column >= this->columns) {
             std::cerr << "Invalid column index: " << column << std::endl;
             return false;
-        } else {
-            this->matrix[row][column] = new_value;
-            return true;
         }
+#endif
+        at(row, column) = new_value;
+        return true;
     }
 
 
     /**
-     * @brief Print the matrix to the console for debugging 
-     * 
-     * @param matrix 2D int array
-     * @param n Dimension of the 2D array
+     * @brief Print the matrix to the console for debugging
+     *
+     * @param out Stream to print to, e.g. a result file.
      */
-    void print_matrix() {
-        std::cout << "  |\t";
+    void print_matrix(std::ostream& out = std::cout) {
+        out << "  |\t";
         for (int i = 0; i < this->dimension; i++) {
-            std::cout << i << "\t";
+            out << i << "\t";
         }
-        std::cout << "\n\n";
+        out << "\n\n";
 
         for (int i = 0; i < this->dimension; i++) {
-            std::cout << i << " |\t";
+            const int* values = row(i);
+            out << i << " |\t";
             for (int j = 0; j < this->dimension; j++) {
-                if(this->matrix[i][j]  >= INFINITY_INT) {
-                    std::cout << "INF ";
+                if(values[j] >= INFINITY_INT) {
+                    out << "INF ";
                 } else {
-                    std::cout << this->matrix[i][j] << "\t";
+                    out << values[j] << "\t";
                 }
             }
-            std::cout << std::endl;
+            out << std::endl;
         }
     }
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef BARRIERS_H
+#define BARRIERS_H
+
+#include "../core/get_time.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#define DEFAULT_BARRIER "blocking"
+#define CACHE_LINE_SIZE 64
+// spins with pause before a waiting thread starts yielding its core
+#define SPIN_LIMIT 1024
+
+
+/**
+ * @brief Common interface of the barrier implementations, every thread
+ *        calling wait() passes its own id in [0, n_threads).
+ */
+class Barrier {
+public:
+    virtual ~Barrier() {}
+    virtual void wait(int thread_id) = 0;
+};
+
+
+// taken from CMPT 431 Spring 2024 Assignment 3
+struct CustomBarrier : public Barrier {
+  int num_of_threads_;
+  int current_waiting_;
+  int barrier_call_;
+  std::mutex my_mutex_;
+  std::condition_variable my_cv_;
+
+  CustomBarrier(int t_num_of_threads)
+      : num_of_threads_(t_num_of_threads), current_waiting_(0),
+        barrier_call_(0) {}
+
+  void wait(int /* thread_id */) override {
+    std::unique_lock<std::mutex> u_lock(my_mutex_);
+    int c = barrier_call_;
+    current_waiting_++;
+    if (current_waiting_ == num_of_threads_) {
+      current_waiting_ = 0;
+      // unlock and send signal to wake up
+      barrier_call_++;
+      u_lock.unlock();
+      my_cv_.notify_all();
+      return;
+    }
+    my_cv_.wait(u_lock, [&] { return (c != barrier_call_); });
+    //  Condition has been reached. return
+  }
+};
+
+
+/**
+ * @brief Exponential backoff for spin loops: pause for 1, 2, 4, ... rounds
+ *        and once SPIN_LIMIT is reached yield the core, so spinning threads
+ *        do not starve the thread everybody waits for when oversubscribed.
+ */
+struct Backoff {
+    int spins = 1;
+
+    void pause() {
+        if (spins <= SPIN_LIMIT) {
+            for (int i = 0; i < spins; i++) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+            spins *= 2;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
+
+
+/**
+ * @brief Base of the types padded to a cache line. Before C++17 operator new
+ *        does not honour an alignas above alignof(max_align_t), so the heap
+ *        copies of these types are allocated with posix_memalign, like the
+ *        rows of Matrix_2D, to keep them on cache lines of their own.
+ */
+struct CacheAligned {
+    static void* operator new(size_t bytes) {
+        void* memory = NULL;
+#ifdef _WIN32
+        memory = _aligned_malloc(bytes, CACHE_LINE_SIZE);
+#else
+        if (posix_memalign(&memory, CACHE_LINE_SIZE, bytes) != 0) { memory = NULL; }
+#endif
+        if (memory == NULL) { throw std::bad_alloc(); }
+        return memory;
+    }
+
+    static void operator delete(void* memory) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    static void* operator new[](size_t bytes) { return operator new(bytes); }
+    static void operator delete[](void* memory) { operator delete(memory); }
+};
+
+
+struct alignas(CACHE_LINE_SIZE) PaddedFlag : public CacheAligned {
+    std::atomic<bool> value;
+    PaddedFlag() : value(false) {}
+};
+
+
+/**
+ * @brief Centralized sense-reversing spin barrier. Arriving threads
+ *        decrement a shared counter, the last one resets it and flips the
+ *        global sense, which releases everybody spinning on it. No kernel
+ *        call is involved as long as the threads have their own core.
+ */
+class SpinBarrier : public Barrier, public CacheAligned {
+
+private:
+    int n_threads;
+    alignas(CACHE_LINE_SIZE) std::atomic<int> remaining;
+    PaddedFlag sense;
+    std::unique_ptr<PaddedFlag[]> local_sense;
+
+public:
+    SpinBarrier(int n_threads)
+        : n_threads(n_threads), remaining(n_threads),
+          local_sense(new PaddedFlag[n_threads]) {}
+
+    void wait(int thread_id) override {
+        bool my_sense = !local_sense[thread_id].value.load(std::memory_order_relaxed);
+        local_sense[thread_id].value.store(my_sense, std::memory_order_relaxed);
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            remaining.store(n_threads, std::memory_order_relaxed);
+            sense.value.store(my_sense, std::memory_order_release);
+            return;
+        }
+        Backoff backoff;
+        while (sense.value.load(std::memory_order_acquire) != my_sense) { backoff.pause(); }
+    }
+};
+
+
+/**
+ * @brief Static tournament barrier. In round r the thread whose id is a
+ *        multiple of 2^(r+1) waits for its partner id + 2^r, so every flag has
+ *        a single writer and a single reader and there is no shared counter
+ *        to contend on with many cores. Thread 0 wins the last round and
+ *        releases everybody by flipping the global sense.
+ */
+class TournamentBarrier : public Barrier, public CacheAligned {
+
+private:
+    int n_threads;
+    int n_rounds;
+    PaddedFlag sense;
+    std::unique_ptr<PaddedFlag[]> local_sense;
+    std::unique_ptr<PaddedFlag[]> arrived; // [round * n_threads + winner]
+
+public:
+    TournamentBarrier(int n_threads)
+        : n_threads(n_threads), n_rounds(0), local_sense(new PaddedFlag[n_threads]) {
+        while ((1 << n_rounds) < n_threads) { n_rounds++; }
+        arrived.reset(new PaddedFlag[(n_rounds + 1) * n_threads]);
+    }
+
+    void wait(int thread_id) override {
+        bool my_sense = !local_sense[thread_id].value.load(std::memory_order_relaxed);
+        local_sense[thread_id].value.store(my_sense, std::memory_order_relaxed);
+
+        for (int round = 0; round < n_rounds; round++) {
+            int step = 1 << round;
+            if (thread_id % (2 * step) == 0) { // winner, wait for the partner
+                if (thread_id + step < n_threads) {
+                    std::atomic<bool>& flag = arrived[round * n_threads + thread_id].value;
+                    Backoff backoff;
+                    while (flag.load(std::memory_order_acquire) != my_sense) { backoff.pause(); }
+                }
+            } else { // loser, report to the winner and wait for the release
+                arrived[round * n_threads + thread_id - step].value.store(
+                    my_sense, std::memory_order_release
+                );
+                Backoff backoff;
+                while (sense.value.load(std::memory_order_acquire) != my_sense) { backoff.pause(); }
+                return;
+            }
+        }
+        sense.value.store(my_sense, std::memory_order_release); // champion
+    }
+};
+
+
+/**
+ * @brief Check if the barrier name is one of blocking, spin, tournament.
+ */
+bool is_barrier_kind(std::string kind) {
+    return kind == "blocking" || kind == "spin" || kind == "tournament";
+}
+
+
+/**
+ * @brief Create a barrier for n_threads threads.
+ *
+ * @param kind blocking (mutex and condition variable), spin (sense-reversing
+ *        spin barrier) or tournament (tree of pairwise flags).
+ */
+Barrier* make_barrier(std::string kind, int n_threads) {
+    if (kind == "spin") { return new SpinBarrier(n_threads); }
+    if (kind == "tournament") { return new TournamentBarrier(n_threads); }
+    return new CustomBarrier(n_threads);
+}
+
+
+/**
+ * @brief Wait at the barrier and add the time spent waiting to wait_time.
+ */
+inline void timed_wait(Barrier* barrier, int thread_id, double* wait_time) {
+    timer wait_timer;
+    wait_timer.start();
+    barrier->wait(thread_id);
+    *wait_time += wait_timer.stop();
+}
+
+#endif
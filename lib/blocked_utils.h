@@ -0,0 +1,97 @@
+#ifndef BLOCKED_UTILS_H
+#define BLOCKED_UTILS_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "min_plus.h"
+#include "path_utils.h"
+#include <algorithm>
+
+#define DEFAULT_TILE_SIZE "64"
+
+
+/**
+ * @brief Relax the tile [row_start, row_end) x [col_start, col_end) through
+ *        the pivots [k_start, k_end). The update is done in place, which is
+ *        valid because row k and column k do not change while k is the pivot.
+ *
+ * @param distances Distance matrix.
+ * @param row_start First row of the tile.
+ * @param row_end One past the last row of the tile.
+ * @param col_start First column of the tile.
+ * @param col_end One past the last column of the tile.
+ * @param k_start First pivot.
+ * @param k_end One past the last pivot.
+ * @param next_hops Next hops updated with the distances, NULL without --paths.
+ */
+inline void update_tile(
+        Matrix_2D* distances,
+        int row_start, int row_end,
+        int col_start, int col_end,
+        int k_start, int k_end,
+        NextHopMatrix* next_hops = NULL) {
+
+    if (next_hops != NULL) {
+        update_block_paths(
+            distances, next_hops, row_start, row_end, col_start, col_end, k_start, k_end
+        );
+        return;
+    }
+    int* tile = distances->row(row_start);
+    min_plus_update(
+        tile + col_start, tile + k_start, distances->row(k_start) + col_start,
+        distances->get_stride(), row_end - row_start, col_end - col_start, k_end - k_start
+    );
+}
+
+
+/**
+ * @brief Cache-blocked Floyd-Warshall. For every block of pivots kb the
+ *        diagonal tile is computed first, then the tiles in pivot row and
+ *        pivot column kb (which only depend on the diagonal tile), then every
+ *        remaining tile (which depends on its pivot row and column tiles).
+ *        Each phase works on tile_size x tile_size blocks that stay in cache.
+ *
+ * @param distances Distance matrix, updated in place.
+ * @param tile_size Width and height of a tile.
+ * @param next_hops Next hops updated with the distances, NULL without --paths.
+ */
+void blocked_floyd_warshall(Matrix_2D* distances, int tile_size, NextHopMatrix* next_hops = NULL) {
+    int n = distances->get_dimension();
+    int n_tiles = (n + tile_size - 1) / tile_size;
+
+    for (int kb = 0; kb < n_tiles; kb++) {
+        int k_start = kb * tile_size;
+        int k_end = std::min(k_start + tile_size, n);
+
+        // phase 1: diagonal tile
+        update_tile(distances, k_start, k_end, k_start, k_end, k_start, k_end, next_hops);
+
+        // phase 2: pivot row and pivot column tiles
+        for (int tile = 0; tile < n_tiles; tile++) {
+            if (tile == kb) { continue; }
+            int start = tile * tile_size;
+            int end = std::min(start + tile_size, n);
+            update_tile(distances, k_start, k_end, start, end, k_start, k_end, next_hops);
+            update_tile(distances, start, end, k_start, k_end, k_start, k_end, next_hops);
+        }
+
+        // phase 3: remaining tiles
+        for (int ib = 0; ib < n_tiles; ib++) {
+            if (ib == kb) { continue; }
+            int row_start = ib * tile_size;
+            int row_end = std::min(row_start + tile_size, n);
+            for (int jb = 0; jb < n_tiles; jb++) {
+                if (jb == kb) { continue; }
+                int col_start = jb * tile_size;
+                int col_end = std::min(col_start + tile_size, n);
+                update_tile(
+                    distances, row_start, row_end, col_start, col_end, k_start, k_end,
+                    next_hops
+                );
+            }
+        }
+    }
+}
+
+#endif
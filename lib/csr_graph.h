@@ -0,0 +1,275 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include "../core/core_utils.h"
+#include "graph_ingest.h"
+#include "graph_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Directed, weighted graph in compressed sparse row form. The edges of
+ *        vertex v are [offsets[v], offsets[v + 1]) of the targets and weights
+ *        arrays, sorted by target with at most one edge per target.
+ *
+ *        The three arrays are views into a single block of storage that the
+ *        graph shares ownership of, so copying a CSRGraph is cheap and the
+ *        storage can be any buffer that outlives the views (a heap allocation
+ *        from build_csr_graph, or a mapped file).
+ */
+class CSRGraph {
+
+private:
+    int n_vertices;
+    int64_t n_edges;
+    std::shared_ptr<const char> storage;
+    const int64_t* offsets;
+    const int* targets;
+    const int* weights;
+
+public:
+    CSRGraph() : n_vertices(0), n_edges(0), offsets(NULL), targets(NULL), weights(NULL) {}
+
+    /**
+     * @param n_vertices Number of vertices.
+     * @param n_edges Number of edges.
+     * @param storage Owner of the memory the arrays point into.
+     * @param offsets n_vertices + 1 edge offsets, offsets[n_vertices] == n_edges.
+     * @param targets Output vertex of every edge.
+     * @param weights Weight of every edge.
+     */
+    CSRGraph(
+            int n_vertices, int64_t n_edges, std::shared_ptr<const char> storage,
+            const int64_t* offsets, const int* targets, const int* weights)
+        : n_vertices(n_vertices), n_edges(n_edges), storage(storage),
+          offsets(offsets), targets(targets), weights(weights) {}
+
+    int get_n_vertices() const { return n_vertices; }
+    int64_t get_n_edges() const { return n_edges; }
+    const int64_t* get_offsets() const { return offsets; }
+    const int* get_targets() const { return targets; }
+    const int* get_weights() const { return weights; }
+
+    int64_t edges_begin(int vertex) const { return offsets[vertex]; }
+    int64_t edges_end(int vertex) const { return offsets[vertex + 1]; }
+    int64_t degree(int vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+    int get_target(int64_t edge) const { return targets[edge]; }
+    int get_weight(int64_t edge) const { return weights[edge]; }
+};
+
+
+/**
+ * @brief Bytes of the single allocation holding a graph: the offsets first
+ *        (8 byte aligned), then the targets and the weights.
+ */
+size_t csr_storage_bytes(int n_vertices, int64_t n_edges) {
+    return (size_t) (n_vertices + 1) * sizeof(int64_t) + (size_t) n_edges * 2 * sizeof(int);
+}
+
+
+/**
+ * @brief Sort the edges of one vertex by target and keep only the lightest
+ *        of every group of parallel edges.
+ *
+ * @param scratch Buffer reused between calls.
+ * @return Number of edges left, stored at the front of targets and weights.
+ */
+int64_t collapse_parallel_edges(
+        int* targets, int* weights, int64_t count, std::vector<std::pair<int, int>>& scratch) {
+
+    scratch.clear();
+    for (int64_t e = 0; e < count; e++) { scratch.push_back(std::make_pair(targets[e], weights[e])); }
+    if (!std::is_sorted(scratch.begin(), scratch.end())) { std::sort(scratch.begin(), scratch.end()); }
+
+    // sorted by (target, weight), so the first edge of every target is the lightest
+    int64_t kept = 0;
+    for (int64_t e = 0; e < count; e++) {
+        if (kept > 0 && targets[kept - 1] == scratch[e].first) { continue; }
+        targets[kept] = scratch[e].first;
+        weights[kept] = scratch[e].second;
+        kept++;
+    }
+    return kept;
+}
+
+
+/**
+ * @brief Weight of the edge (from, to), INFINITY_INT if the graph has none.
+ */
+int edge_weight(const CSRGraph& graph, int from, int to) {
+    const int* targets = graph.get_targets();
+    const int* first = targets + graph.edges_begin(from);
+    const int* last = targets + graph.edges_end(from);
+    const int* found = std::lower_bound(first, last, to);
+    if (found == last || *found != to) { return INFINITY_INT; }
+    return std::min(graph.get_weight(found - targets), INFINITY_INT);
+}
+
+
+/**
+ * @brief Copy of the graph with the edge (from, to) set to weight: inserted
+ *        if the graph has none, removed if weight is INFINITY_INT or more.
+ *        The copy has its own storage, O(vertices + edges).
+ */
+CSRGraph with_edge_weight(const CSRGraph& graph, int from, int to, int weight) {
+    int n = graph.get_n_vertices();
+    const int* targets = graph.get_targets();
+    int64_t begin = graph.edges_begin(from);
+    int64_t end = graph.edges_end(from);
+    int64_t position = std::lower_bound(targets + begin, targets + end, to) - targets;
+    bool found = position < end && targets[position] == to;
+    bool keep = weight < INFINITY_INT;
+    int64_t delta = (keep ? 1 : 0) - (found ? 1 : 0);
+    int64_t n_edges = graph.get_n_edges() + delta;
+
+    char* buffer = new char[csr_storage_bytes(n, n_edges)];
+    std::shared_ptr<const char> storage(buffer, std::default_delete<char[]>());
+    int64_t* offsets = (int64_t*) buffer;
+    int* new_targets = (int*) (offsets + n + 1);
+    int* new_weights = new_targets + n_edges;
+
+    for (int vertex = 0; vertex <= n; vertex++) {
+        offsets[vertex] = graph.get_offsets()[vertex] + (vertex > from ? delta : 0);
+    }
+    // edges before the changed one, the changed one, then the edges after it
+    int64_t skipped = position + (found ? 1 : 0);
+    std::memcpy(new_targets, targets, position * sizeof(int));
+    std::memcpy(new_weights, graph.get_weights(), position * sizeof(int));
+    if (keep) {
+        new_targets[position] = to;
+        new_weights[position] = weight;
+    }
+    int64_t rest = graph.get_n_edges() - skipped;
+    int64_t moved_to = position + (keep ? 1 : 0);
+    std::memcpy(new_targets + moved_to, targets + skipped, rest * sizeof(int));
+    std::memcpy(new_weights + moved_to, graph.get_weights() + skipped, rest * sizeof(int));
+
+    return CSRGraph(n, n_edges, storage, offsets, new_targets, new_weights);
+}
+
+
+/**
+ * @brief Build the graph of the lines of a buffer in two passes over the
+ *        text: the first counts the edges of every vertex, which sizes the
+ *        one allocation, the second parses the edges into place. Both passes
+ *        and the collapsing of parallel edges run on n_threads threads, each
+ *        on its own range of vertices.
+ *
+ * @param data Buffer holding the file.
+ * @param lines Lines of the buffer, line i holds the edges of vertex i.
+ * @param n_threads Number of threads building the graph.
+ * @param graph Built graph.
+ * @return false if an edge points outside of [0, lines.size()).
+ */
+bool build_csr_graph(
+        const char* data, const std::vector<LineSpan>& lines, int n_threads, CSRGraph& graph) {
+
+    int n = lines.size();
+    n_threads = std::max(1, std::min(n_threads, n));
+    std::vector<int64_t> counts(n + 1, 0);
+    std::atomic<bool> valid(true);
+
+    // pass 1: count and validate
+    run_ingest_threads(n_threads, [&](int thread_id) {
+        int start_vertex, end_vertex;
+        vertex_range(lines, thread_id, n_threads, &start_vertex, &end_vertex);
+        for (int vertex = start_vertex; vertex < end_vertex; vertex++) {
+            counts[vertex] = parse_edge_line(
+                data + lines[vertex].begin, data + lines[vertex].end,
+                [&](int target, int) { if (target < 0 || target >= n) { valid = false; } }
+            );
+        }
+    });
+    if (!valid) { return false; }
+
+    int64_t n_edges = 0;
+    for (int vertex = 0; vertex <= n; vertex++) {
+        int64_t count = counts[vertex];
+        counts[vertex] = n_edges;
+        n_edges += count;
+    }
+
+    char* buffer = new char[csr_storage_bytes(n, n_edges)];
+    std::shared_ptr<const char> storage(buffer, std::default_delete<char[]>());
+    int64_t* offsets = (int64_t*) buffer;
+    int* targets = (int*) (offsets + n + 1);
+    int* weights = targets + n_edges;
+
+    // pass 2: parse into place and collapse parallel edges
+    std::vector<int64_t> kept(n, 0);
+    run_ingest_threads(n_threads, [&](int thread_id) {
+        int start_vertex, end_vertex;
+        vertex_range(lines, thread_id, n_threads, &start_vertex, &end_vertex);
+        std::vector<std::pair<int, int>> scratch;
+        for (int vertex = start_vertex; vertex < end_vertex; vertex++) {
+            int64_t edge = counts[vertex];
+            parse_edge_line(
+                data + lines[vertex].begin, data + lines[vertex].end,
+                [&](int target, int weight) {
+                    targets[edge] = target;
+                    weights[edge] = weight;
+                    edge++;
+                }
+            );
+            kept[vertex] = collapse_parallel_edges(
+                targets + counts[vertex], weights + counts[vertex],
+                edge - counts[vertex], scratch
+            );
+        }
+    });
+
+    // close the gaps left by collapsed edges, segments only move to the left
+    int64_t n_kept = 0;
+    for (int vertex = 0; vertex < n; vertex++) {
+        offsets[vertex] = n_kept;
+        if (n_kept != counts[vertex]) {
+            std::memmove(targets + n_kept, targets + counts[vertex], kept[vertex] * sizeof(int));
+            std::memmove(weights + n_kept, weights + counts[vertex], kept[vertex] * sizeof(int));
+        }
+        n_kept += kept[vertex];
+    }
+    offsets[n] = n_kept;
+    if (n_kept != n_edges) { // weights directly follow the kept targets
+        std::memmove(targets + n_kept, weights, n_kept * sizeof(int));
+    }
+
+    graph = CSRGraph(n, n_kept, storage, offsets, targets, targets + n_kept);
+    return true;
+}
+
+
+/**
+ * @brief Seed one row of a distance matrix from the graph: 0 on the diagonal
+ *        and the weight (clamped to INFINITY_INT) of every edge of the vertex
+ *        whose target is in [col_start, col_end). The other entries are left
+ *        alone, the row is expected to be filled with INFINITY_INT.
+ *
+ * @param row Row of the vertex, row[j] is column col_start + j.
+ * @param graph Graph to read the edges from.
+ * @param vertex Vertex of the row.
+ * @param col_start First column held by row.
+ * @param col_end One past the last column held by row.
+ */
+void seed_distance_row(int* row, const CSRGraph& graph, int vertex, int col_start, int col_end) {
+    // targets are sorted, jump straight to the columns of the row
+    const int* targets = graph.get_targets();
+    const int* first = std::lower_bound(
+        targets + graph.edges_begin(vertex), targets + graph.edges_end(vertex), col_start
+    );
+    for (int64_t edge = first - targets; edge < graph.edges_end(vertex); edge++) {
+        int target = targets[edge];
+        if (target >= col_end) { break; }
+        row[target - col_start] = std::min(graph.get_weight(edge), INFINITY_INT);
+    }
+    if (vertex >= col_start && vertex < col_end) {
+        row[vertex - col_start] = 0; // self loops have a weight of 0
+    }
+}
+
+#endif
@@ -1,218 +1,540 @@
 #include "../core/core_utils.h"
 #include "Edge.h"
 #include "Matrix_2D.h"
+#include "checkpoint_utils.h"
+#include "csr_graph.h"
+#include "graph_ingest.h"
+#include "matrix_output.h"
+#include "min_plus.h"
+#include <cstring>
+#include <functional>
 #include <map>
+#include <memory>
 #include <vector>
-#include <sstream>
 #include <mpi.h>
 
+// rows relaxed between two polls of the in-flight pivot broadcasts
+#define PROGRESS_INTERVAL 16
+
 /**
- * @brief Given a csv line, seperate them such that the ith character is
- *        the output vertex and the i+1th character is the wieght of the edge. 
- * 
- * @param edges A map of input vertices with a key of edges.
- * @param input_vertex Input vertex for the directed edge.
- * @param csv_line String of output vertices and weights.
+ * @brief Process of a 2D (checkerboard) process grid and the block of the
+ *        distance matrix it owns: rows [row_start, row_end) and columns
+ *        [col_start, col_end).
  */
-void generate_edges(
-        std::map<int, std::vector<Edge>>& edges, 
-        int input_vertex, 
-        std::string csv_line
-    ) {
-    
-    std::stringstream ss(csv_line);
-    std::vector<int> values;
-
-    int value;
-    // Read values from stringstream separated by commas
-    while (ss >> value) {
-        values.push_back(value);
-        if (ss.peek() == ',') {ss.ignore(); } // ignore the commas
-    }
-    
-    int mod = 0;
-    int weight;
-    int output_vertex;
-    while (!values.empty()) { // extract the edge weights and the output vertices
-        if (mod == 0) { // value is an output vertex
-            output_vertex = values.front();
-        } else { // value is a weight
-            weight = values.front();
-
-            // create an edge
-            edges[input_vertex].push_back(Edge(input_vertex, output_vertex, weight));
+struct GridBlock {
+    MPI_Comm grid;     // 2D cartesian communicator
+    MPI_Comm row_comm; // processes of the same grid row, ordered by grid column
+    MPI_Comm col_comm; // processes of the same grid column, ordered by grid row
+    int dims[2];       // grid rows, grid columns
+    int coords[2];     // grid row, grid column of this process
+    int row_start;
+    int row_end;
+    int col_start;
+    int col_end;
+};
+
+
+/**
+ * @brief First index of part `index` when n indices are split into `parts`
+ *        balanced contiguous ranges.
+ */
+int block_start(int n, int parts, int index) {
+    return (int) (((long) n * index) / parts);
+}
+
+
+/**
+ * @brief Part owning the index when n indices are split into `parts`.
+ */
+int block_owner(int n, int parts, int index) {
+    int owner = (int) (((long) index * parts) / n);
+    while (block_start(n, parts, owner + 1) <= index) { owner++; }
+    while (block_start(n, parts, owner) > index) { owner--; }
+    return owner;
+}
+
+
+/**
+ * @brief Arrange the processes of MPI_COMM_WORLD in a 2D cartesian grid and
+ *        compute the block of the n x n matrix owned by this process.
+ */
+GridBlock create_grid_block(int n) {
+    GridBlock block;
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    block.dims[0] = 0;
+    block.dims[1] = 0;
+    MPI_Dims_create(world_size, 2, block.dims);
+    int periods[2] = {0, 0};
+    MPI_Cart_create(MPI_COMM_WORLD, 2, block.dims, periods, 1, &block.grid);
+
+    int grid_rank;
+    MPI_Comm_rank(block.grid, &grid_rank);
+    MPI_Cart_coords(block.grid, grid_rank, 2, block.coords);
+
+    int keep_columns[2] = {0, 1};
+    int keep_rows[2] = {1, 0};
+    MPI_Cart_sub(block.grid, keep_columns, &block.row_comm);
+    MPI_Cart_sub(block.grid, keep_rows, &block.col_comm);
+
+    block.row_start = block_start(n, block.dims[0], block.coords[0]);
+    block.row_end = block_start(n, block.dims[0], block.coords[0] + 1);
+    block.col_start = block_start(n, block.dims[1], block.coords[1]);
+    block.col_end = block_start(n, block.dims[1], block.coords[1] + 1);
+    return block;
+}
+
+
+void free_grid_block(GridBlock& block) {
+    MPI_Comm_free(&block.row_comm);
+    MPI_Comm_free(&block.col_comm);
+    MPI_Comm_free(&block.grid);
+}
+
+
+/**
+ * @brief Initialize the local block: 0 on the diagonal and the edge weight
+ *        (clamped to INFINITY_INT) for every edge that falls in the block.
+ *        Only the lines of the block's rows are parsed, straight from the
+ *        mapped input file into the block.
+ *
+ * @return false if an edge points outside of the graph.
+ */
+bool block_init(
+        Matrix_2D* distances, GridBlock& block, const char* data, std::vector<LineSpan>& lines) {
+
+    for (int vertex = block.row_start; vertex < block.row_end; vertex++) {
+        int local_row = vertex - block.row_start;
+        if (vertex >= block.col_start && vertex < block.col_end) {
+            // self loops have a weight of 0
+            distances->set_matrix_value(local_row, vertex - block.col_start, 0);
         }
-        values.erase(values.begin());
-        mod = (mod + 1) % 2;
+        bool valid = true;
+        int* row = distances->row(local_row);
+        parse_edge_line(
+            data + lines[vertex].begin, data + lines[vertex].end,
+            [&](int target, int weight) {
+                if (target < 0 || target >= (int) lines.size()) { valid = false; }
+                if (target < block.col_start || target >= block.col_end) { return; }
+                // parallel edges collapse to the lightest one, as in CSRGraph
+                weight = target == vertex ? 0 : std::min(weight, INFINITY_INT);
+                row[target - block.col_start] = std::min(row[target - block.col_start], weight);
+            }
+        );
+        if (!valid) { return false; }
     }
+    return true;
 }
 
-bool graph_init(Matrix_2D* distances, std::vector<std::string> csv_lines){
-    std::map<int, std::vector<Edge>> edges;
-    for (int i = 0; i < csv_lines.size(); i++) {
-        edges[i];
-        generate_edges(edges, i, csv_lines[i]);
+
+/**
+ * @brief Initialize the local block from a graph, used for binary graph
+ *        files which need no parsing.
+ */
+bool block_init(Matrix_2D* distances, GridBlock& block, const CSRGraph& graph) {
+    for (int vertex = block.row_start; vertex < block.row_end; vertex++) {
+        seed_distance_row(
+            distances->row(vertex - block.row_start), graph, vertex, block.col_start, block.col_end
+        );
     }
+    return true;
+}
 
-    for (int vertex = 0; vertex < csv_lines.size(); vertex++) {
-        distances->set_matrix_value(vertex,vertex, 0); // self loops have a weight of 0
-        for (Edge edge: edges[vertex]) {
-            bool result;
-            if (edge.is_self_loop()) { // self loops have a weight of 0
-                result = distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_input_vertex(), 0
-                );
-            } else {
-                result = distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_output_vertex(), edge.get_weight()
-                );
+
+/**
+ * @brief Time spent on the pivot broadcasts of one process. comm_time runs
+ *        from posting a broadcast until it is seen complete, exposed_wait is
+ *        the part of it spent blocked in MPI_Waitall; the rest was hidden
+ *        behind the relaxation.
+ */
+struct PivotStats {
+    double comm_time = 0;
+    double exposed_wait = 0;
+
+    double overlap() { return comm_time > 0 ? 1 - exposed_wait / comm_time : 1; }
+};
+
+
+/**
+ * @brief Relax local row i of the block with the pivot segments.
+ */
+inline void relax_block_row(Matrix_2D* distances, int i, const int* column_k, const int* row_k) {
+    min_plus_update(
+        distances->row(i), &column_k[i], row_k, distances->get_stride(),
+        1, distances->get_columns(), 1
+    );
+}
+
+
+/**
+ * @brief Floyd-Warshall on a 2D block decomposition. For every k the owners
+ *        of row k broadcast their segment of it down their process column and
+ *        the owners of column k broadcast their segment across their process
+ *        row, then every process relaxes its own block. Each process keeps
+ *        n^2/p entries and receives O(n/sqrt(p)) values per k.
+ *
+ *        The broadcasts are non-blocking and pipelined with a lookahead of
+ *        one pivot: after receiving pivot k, the owners of row and column
+ *        k+1 relax those first, post the k+1 broadcasts and only then relax
+ *        the rest of their block with pivot k, polling MPI every
+ *        PROGRESS_INTERVAL rows so the k+1 transfer progresses meanwhile.
+ *
+ *        When a checkpoint is due after pivot k, the block is copied for the
+ *        writer thread while the k+1 broadcasts are in flight.
+ *
+ * @param distances Local block, updated in place.
+ * @param block Position of the block in the grid.
+ * @param n Number of vertices.
+ * @param stats Broadcast timings of this process.
+ * @param first_pivot Pivots already applied to the block.
+ * @param checkpoint Writer of the checkpoints of this process, NULL for none.
+ */
+void checkerboard_floyd_warshall(
+        Matrix_2D* distances, GridBlock& block, int n, PivotStats* stats,
+        int first_pivot = 0, CheckpointWriter* checkpoint = NULL) {
+    int local_rows = block.row_end - block.row_start;
+    int local_cols = block.col_end - block.col_start;
+    // double buffered: pivot k is relaxed while pivot k+1 is in flight
+    std::vector<int> row_buffers[2] = {std::vector<int>(local_cols), std::vector<int>(local_cols)};
+    std::vector<int> column_buffers[2] = {std::vector<int>(local_rows), std::vector<int>(local_rows)};
+
+    MPI_Request requests[2];
+    double posted_at = 0;
+    double completed_at = 0;
+    bool completed = true;
+
+    auto post = [&](int k) {
+        int row_owner = block_owner(n, block.dims[0], k);
+        int col_owner = block_owner(n, block.dims[1], k);
+        std::vector<int>& row_k = row_buffers[k % 2];
+        std::vector<int>& column_k = column_buffers[k % 2];
+
+        if (block.coords[0] == row_owner) {
+            std::memcpy(row_k.data(), distances->row(k - block.row_start), local_cols * sizeof(int));
+        }
+        if (block.coords[1] == col_owner) {
+            for (int i = 0; i < local_rows; i++) {
+                column_k[i] = distances->row(i)[k - block.col_start];
             }
-            if (!result) { 
-                // If we failed to create the graph for some reason.
-                // If this happens, we cannot continue, so shut down other processes.
-                return false; 
+        }
+        MPI_Ibcast(row_k.data(), local_cols, MPI_INT, row_owner, block.col_comm, &requests[0]);
+        MPI_Ibcast(column_k.data(), local_rows, MPI_INT, col_owner, block.row_comm, &requests[1]);
+        posted_at = MPI_Wtime();
+        completed = false;
+    };
+
+    auto progress = [&]() {
+        if (completed) { return; }
+        int flag;
+        MPI_Testall(2, requests, &flag, MPI_STATUSES_IGNORE);
+        if (flag) {
+            completed = true;
+            completed_at = MPI_Wtime();
+        }
+    };
+
+    auto finish = [&]() {
+        if (!completed) {
+            double wait_start = MPI_Wtime();
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+            completed_at = MPI_Wtime();
+            stats->exposed_wait += completed_at - wait_start;
+            completed = true;
+        }
+        stats->comm_time += completed_at - posted_at;
+    };
+
+    if (first_pivot >= n) { return; }
+    post(first_pivot);
+    for (int k = first_pivot; k < n; k++) {
+        finish();
+        const int* row_k = row_buffers[k % 2].data();
+        const int* column_k = column_buffers[k % 2].data();
+
+        // lookahead: finish the parts of pivot k+1 we own and send them first
+        int next = k + 1;
+        int skip_row = -1;
+        if (next < n) {
+            if (next >= block.row_start && next < block.row_end) {
+                skip_row = next - block.row_start;
+                relax_block_row(distances, skip_row, column_k, row_k);
+            }
+            if (next >= block.col_start && next < block.col_end) {
+                int column = next - block.col_start;
+                for (int i = 0; i < local_rows; i++) {
+                    if (column_k[i] >= INFINITY_INT) { continue; }
+                    int* row_i = distances->row(i);
+                    row_i[column] = std::min(row_i[column], column_k[i] + row_k[column]);
+                }
             }
+            post(next);
+        }
+
+        for (int i = 0; i < local_rows; i++) {
+            if (i != skip_row) { relax_block_row(distances, i, column_k, row_k); }
+            if (i % PROGRESS_INTERVAL == 0) { progress(); }
+        }
+        if (checkpoint != NULL && checkpoint->due(k + 1)) {
+            checkpoint->snapshot_part(distances, NULL, 0, local_rows, k + 1);
         }
     }
-    return true;
 }
 
-void transmit_pack(Matrix_2D* distances, int send_buffer[]){
-    int cur_cell = 0;
 
-    for(int i = 0; i < distances->get_dimension(); i++){
-        for(int j = 0; j < distances->get_dimension(); j++){
-            send_buffer[cur_cell] = distances->get_matrix_value(i, j);
-            cur_cell++;
+/**
+ * @brief Collect every block on rank 0 of the grid.
+ *
+ * @return The full matrix on rank 0, NULL on the other ranks.
+ */
+Matrix_2D* gather_blocks(Matrix_2D* distances, GridBlock& block, int n) {
+    int grid_rank;
+    int grid_size;
+    MPI_Comm_rank(block.grid, &grid_rank);
+    MPI_Comm_size(block.grid, &grid_size);
+
+    int local_rows = block.row_end - block.row_start;
+    int local_cols = block.col_end - block.col_start;
+    if (grid_rank != 0) {
+        std::vector<int> packed((size_t) local_rows * local_cols);
+        for (int i = 0; i < local_rows; i++) {
+            std::memcpy(&packed[(size_t) i * local_cols], distances->row(i), local_cols * sizeof(int));
         }
+        MPI_Send(packed.data(), packed.size(), MPI_INT, 0, 0, block.grid);
+        return NULL;
     }
+
+    Matrix_2D* full = new Matrix_2D(n, INFINITY_INT);
+    for (int i = 0; i < local_rows; i++) {
+        std::memcpy(full->row(block.row_start + i) + block.col_start, distances->row(i), local_cols * sizeof(int));
+    }
+    for (int source = 1; source < grid_size; source++) {
+        int coords[2];
+        MPI_Cart_coords(block.grid, source, 2, coords);
+        int row_start = block_start(n, block.dims[0], coords[0]);
+        int row_end = block_start(n, block.dims[0], coords[0] + 1);
+        int col_start = block_start(n, block.dims[1], coords[1]);
+        int col_end = block_start(n, block.dims[1], coords[1] + 1);
+
+        std::vector<int> packed((size_t) (row_end - row_start) * (col_end - col_start));
+        MPI_Recv(packed.data(), packed.size(), MPI_INT, source, 0, block.grid, MPI_STATUS_IGNORE);
+        for (int i = row_start; i < row_end; i++) {
+            std::memcpy(
+                full->row(i) + col_start, &packed[(size_t) (i - row_start) * (col_end - col_start)],
+                (col_end - col_start) * sizeof(int)
+            );
+        }
+    }
+    return full;
+}
+
+
+/**
+ * @brief Write the distances as one binary matrix file (see
+ *        MatrixFileHeader) without gathering them: every process sets a file
+ *        view selecting its block of the row-major matrix and writes it
+ *        straight from its padded rows with one collective MPI-IO call.
+ *
+ * @return false on every process if the file could not be written.
+ */
+bool write_distributed_matrix(Matrix_2D* distances, GridBlock& block, int n, std::string path) {
+    int local_rows = block.row_end - block.row_start;
+    int local_cols = block.col_end - block.col_start;
+    int grid_rank;
+    MPI_Comm_rank(block.grid, &grid_rank);
+
+    MPI_File file;
+    int status = MPI_File_open(
+        block.grid, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file
+    );
+    if (status != MPI_SUCCESS) { return false; }
+
+    MatrixFileHeader header = matrix_file_header(n, n);
+    MPI_Offset file_size = header.data_offset + (MPI_Offset) n * n * sizeof(int);
+    status |= MPI_File_set_size(file, file_size); // drop what an older, larger file left
+    if (grid_rank == 0) {
+        status |= MPI_File_write_at(
+            file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE
+        );
+    }
+
+    // where the block goes in the file and where it comes from in memory
+    int sizes[2] = {n, n};
+    int subsizes[2] = {local_rows, local_cols};
+    int starts[2] = {block.row_start, block.col_start};
+    MPI_Datatype file_block, memory_block;
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_INT, &file_block);
+    MPI_Type_vector(local_rows, local_cols, distances->get_stride(), MPI_INT, &memory_block);
+    MPI_Type_commit(&file_block);
+    MPI_Type_commit(&memory_block);
+
+    status |= MPI_File_set_view(
+        file, header.data_offset, MPI_INT, file_block, "native", MPI_INFO_NULL
+    );
+    status |= MPI_File_write_all(
+        file, local_rows > 0 ? distances->row(0) : NULL, local_rows > 0 ? 1 : 0,
+        memory_block, MPI_STATUS_IGNORE
+    );
+    MPI_Type_free(&file_block);
+    MPI_Type_free(&memory_block);
+    status |= MPI_File_close(&file);
+
+    int failed = status != MPI_SUCCESS;
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, block.grid);
+    return !failed;
 }
 
-void transmit_unpack(Matrix_2D* distances, int receive_buffer[]){
-    int cur_cell = 0;
 
-    for(int i = 0; i < distances->get_dimension(); i++){
-        for(int j = 0; j < distances->get_dimension(); j++){
-            distances->set_matrix_value(i, j, receive_buffer[cur_cell]); 
-            cur_cell++;
+/**
+ * @brief Load the newest checkpoint every process of the grid has, in its
+ *        checkpoint file or the .prev of it. When the run stopped, a process
+ *        may have written one more checkpoint than another, and the .prev
+ *        files still hold the one before.
+ *
+ * @param path Checkpoint file of this process.
+ * @param header Header of the checkpoints of this process.
+ * @param distances Initialized local block, initialized again if a process
+ *        failed to read its checkpoint.
+ * @return Pivots applied by the checkpoint, 0 if there is none.
+ */
+int resume_block_checkpoint(
+        std::string path, const CheckpointHeader& header, Matrix_2D* distances, GridBlock& block,
+        std::function<bool(Matrix_2D*, GridBlock&)> init_block) {
+    int grid_size;
+    MPI_Comm_size(block.grid, &grid_size);
+    int pivots[2] = {checkpoint_pivot(path, header), checkpoint_pivot(previous_checkpoint_path(path), header)};
+    std::vector<int> all_pivots(2 * grid_size);
+    MPI_Allgather(pivots, 2, MPI_INT, all_pivots.data(), 2, MPI_INT, block.grid);
+
+    int pivot = 0;
+    for (int candidate : all_pivots) {
+        if (candidate <= pivot) { continue; }
+        bool everywhere = true;
+        for (int r = 0; r < grid_size; r++) {
+            everywhere &= all_pivots[2 * r] == candidate || all_pivots[2 * r + 1] == candidate;
         }
+        if (everywhere) { pivot = candidate; }
     }
+    if (pivot == 0) { return 0; }
+
+    int local_rows = block.row_end - block.row_start;
+    std::string file = pivots[0] == pivot ? path : previous_checkpoint_path(path);
+    int failed = !read_checkpoint_rows(file, distances, NULL, 0, local_rows);
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, block.grid);
+    if (!failed) { return pivot; }
+
+    distances->fill_rows(0, local_rows, INFINITY_INT);
+    init_block(distances, block);
+    return 0;
 }
 
-bool all_pairs_distributed(std::vector<std::string> csv_lines) {
-    MPI_Init(nullptr, nullptr);
 
-    MPI_Status mpi_status;
-    int rank;
-    int world_size;
+/**
+ * @brief Distributed Floyd-Warshall on a 2D process grid.
+ *
+ * @param n Number of vertices.
+ * @param init_block Initializes the block of this process, see block_init.
+ * @param output_file File receiving the result, empty to print it.
+ * @param output_format text (gathered on rank 0 of the grid) or binary
+ *        (written by every process, see write_distributed_matrix).
+ * @param checkpoint_options Every process checkpoints its block to
+ *        <path>.rank<grid rank>, --resume restarts from the newest pivot all
+ *        of them have.
+ */
+bool all_pairs_distributed(
+        int n, std::function<bool(Matrix_2D*, GridBlock&)> init_block,
+        std::string output_file, std::string output_format,
+        CheckpointOptions checkpoint_options = CheckpointOptions()) {
+    MPI_Init(nullptr, nullptr);
 
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
 
     timer distributed_timer;
     distributed_timer.start();
-    
-    Matrix_2D* distances = new Matrix_2D(csv_lines.size(), INFINITY_INT);
-
-    int send_buffer[csv_lines.size() * csv_lines.size()];
-    int receive_buffer[csv_lines.size() * csv_lines.size()];
-
-    if(rank == 0){
-        // initalize the distances. Only the "root" process has to do this,
-        // since the root is about to broadcast its results to the other processes anyway.
-        // If the initialization fails, then we can't proceed anyway, so just abort in that case.
-        if(!graph_init(distances, csv_lines)){
-            return false;
-            MPI_Abort(MPI_COMM_WORLD, -1);
-        }
 
-        // Now we're going to need to broadcast this to the other processes.
-        // Packing the results into a single 1D array makes transmission much easier.
-        transmit_pack(distances, send_buffer);
-    }
+    // Every process only holds its own n/sqrt(p) x n/sqrt(p) block
+    GridBlock block = create_grid_block(n);
+    Matrix_2D* distances = new Matrix_2D(
+        block.row_end - block.row_start, block.col_end - block.col_start, INFINITY_INT
+    );
 
-    MPI_Bcast(send_buffer, distances->get_dimension() * distances->get_dimension(), MPI_INT, 0, MPI_COMM_WORLD); 
-
-    // Decompose the work across the processes
-    // This form of decomposition means the last process in the list will do a disproportionate amount of work
-    // in the case where there's a large number of processes compared to the size of the graph.
-    // In that case, communication overhead will cost more than just waiting for that last process to complete,
-    // so this isn't really a problem to begin with.
-    int step_size = distances->get_dimension() / world_size;
-    int start_k = step_size * rank;
-    int stop_k = start_k + step_size;
-
-    // Adjust k value to account for starting at 0, not 1
-    stop_k--;
-    // Final process gets end k value overwritten to avoid segfault
-    if(rank == world_size - 1){ stop_k = distances->get_dimension(); }
-    // All but first process gets start k overwritten to cross process boundaries reliably
-    if(rank != 0){ start_k--; }
-
-    int iterations;
-    if(world_size > 2){
-        iterations = 3;
-    } else {
-        iterations = world_size;
+    // If the initialization fails we can't proceed, so shut down the other processes.
+    if (!init_block(distances, block)) {
+        MPI_Abort(MPI_COMM_WORLD, -1);
+        return false;
     }
 
-    // Compute the shortest paths
-    // This process must run at least twice:
-    //      1. First iteration computes the values for the "local" values of k
-    //      2. Then we broadcast our results to the other processes with MPI_Allreduce
-    //      3. MPI_Allreduce gives us the best results for each node across every process
-    //      4. Then run it again, serving to both check our work, 
-    //         and handle process boundaries once the results get broadcast to the others
-    //
-    //      With 2 processes, running twice is sufficient, but otherwise we must run it 3 times.
-    //
-    // This seems inefficient on first glance, but this is still faster than the serial version
-    // if we use enough processes.
-    // Even with only 2 or 3 processes, this is still equivalent to the serial version,
-    // because the step size will be reduced, and 3(N*N*(N/3)) = N^3 for all N.
-    // With 4 or more processes, this is faster than the serial implementation. 
-    for(int i = 0; i < iterations; i++){
-        for (int k = start_k; k < stop_k; k++) {
-            for (int j = 0; j < csv_lines.size(); j++) {
-                for (int i = 0; i < csv_lines.size(); i++) {
-                    if(i != j){
-                        try {
-                            int current_path_weight = distances->get_matrix_value(i, j);
-                            int new_path_weight = distances->get_matrix_value(i, k) 
-                                                + distances->get_matrix_value(k, j);
-
-                            if (current_path_weight > new_path_weight) {
-                                distances->set_matrix_value(i, j, new_path_weight);
-                            }
-                        } catch (const IndexOutOfBoundsException& e) {
-                            return false;
-                        }
-                    }
-                }
-            }
-        }
-
-        // By using MPI_Allreduce and MPI_MIN, we automatically get the minimum value for each value in the matrix,
-        // and the result gets broadcast back to each process.
-        MPI_Barrier(MPI_COMM_WORLD);
+    int grid_rank, grid_size;
+    MPI_Comm_rank(block.grid, &grid_rank);
+    MPI_Comm_size(block.grid, &grid_size);
 
-        transmit_pack(distances, send_buffer);
-        MPI_Allreduce(send_buffer, receive_buffer, distances->get_dimension() * distances->get_dimension(), MPI_INT, MPI_MIN, MPI_COMM_WORLD);
-        transmit_unpack(distances, receive_buffer);
+    int first_pivot = 0;
+    std::unique_ptr<CheckpointWriter> checkpoint;
+    if (checkpoint_options.enabled()) {
+        std::string path = rank_checkpoint_path(checkpoint_options.path, grid_rank);
+        CheckpointHeader header = checkpoint_header(
+            n, checkpoint_options.fingerprint, block.row_start, block.row_end,
+            block.col_start, block.col_end, 0
+        );
+        if (checkpoint_options.resume) {
+            first_pivot = resume_block_checkpoint(path, header, distances, block, init_block);
+        }
+        checkpoint.reset(new CheckpointWriter(path, header, checkpoint_options.interval, 1));
     }
 
+    PivotStats stats;
+    checkerboard_floyd_warshall(distances, block, n, &stats, first_pivot, checkpoint.get());
+
     // Output the results
     double time_taken = distributed_timer.stop();
+    bool binary_output = output_format == "binary";
+    bool written = true;
+    Matrix_2D* full = NULL;
+    if (binary_output) {
+        written = write_distributed_matrix(distances, block, n, output_file);
+    } else {
+        full = gather_blocks(distances, block, n);
+    }
+
+    double local_stats[2] = {stats.comm_time, stats.exposed_wait};
+    std::vector<double> all_stats(2 * grid_size);
+    MPI_Gather(local_stats, 2, MPI_DOUBLE, all_stats.data(), 2, MPI_DOUBLE, 0, block.grid);
 
-    if(rank == 0){
-        std::cout << "Final matrix\n";
-        distances->print_matrix();    
+    if (grid_rank == 0) {
+        if (full != NULL) {
+            written = output_matrix(
+                full, output_file, output_format, ingest_threads(),
+                short_lived_threads(ingest_threads())
+            );
+        }
+        if (!written && binary_output) {
+            std::cout << "Unable to write file (" << output_file << ")" << std::endl;
+        }
         std::cout << "Time taken: " << time_taken << std::endl; 
+        std::cout << "rank,\tcomm_time,\texposed_wait,\toverlap\n";
+        std::string delim = ",\t";
+        for (int r = 0; r < grid_size; r++) {
+            PivotStats rank_stats;
+            rank_stats.comm_time = all_stats[2 * r];
+            rank_stats.exposed_wait = all_stats[2 * r + 1];
+            std::cout << r << delim << rank_stats.comm_time << delim << rank_stats.exposed_wait
+                      << delim << rank_stats.overlap() << std::endl;
+        }
     }
 
+    // the checkpoints go once the result is written, rank 0 knows for text
+    if (checkpoint) {
+        int keep = !written;
+        MPI_Bcast(&keep, 1, MPI_INT, 0, block.grid);
+        checkpoint->finish();
+        if (!keep) { checkpoint->remove_files(); }
+        if (grid_rank == 0) { std::cout << describe_checkpoints(*checkpoint, first_pivot) << std::endl; }
+    }
+
+    delete full;
     delete distances;
+    free_grid_block(block);
 
     MPI_Barrier(MPI_COMM_WORLD);
     MPI_Finalize();
-    return true;
-}
\ No newline at end of file
+    return written;
+}
@@ -0,0 +1,370 @@
+#ifndef DYNAMIC_UTILS_H
+#define DYNAMIC_UTILS_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "csr_graph.h"
+#include "graph_ingest.h"
+#include "matrix_format.h"
+#include "matrix_output.h"
+#include "sparse_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define DEFAULT_UPDATE_THREADS "4"
+
+
+/**
+ * @brief New weight of the directed edge (from, to), inserting it if the
+ *        graph had none. A weight of INFINITY_INT deletes the edge.
+ */
+struct EdgeUpdate {
+    int from;
+    int to;
+    int weight;
+};
+
+
+/**
+ * @brief Entry of the distance matrix changed by a batch of updates.
+ */
+struct DistanceChange {
+    int from;
+    int to;
+    int old_distance;
+    int new_distance;
+};
+
+
+/**
+ * @brief Copy a mapped distance matrix into a Matrix_2D that can be updated.
+ *
+ * @param matrix Mapped binary matrix, square with 4 byte elements.
+ * @return Copy of the distances, NULL if the matrix is not a distance matrix.
+ */
+Matrix_2D* copy_mapped_matrix(const MappedMatrix& matrix) {
+    if (matrix.header.element_bytes != sizeof(int32_t) || matrix.header.rows != matrix.header.columns) {
+        return NULL;
+    }
+    int n = (int) matrix.header.rows;
+    Matrix_2D* distances = new Matrix_2D(n);
+    for (int i = 0; i < n; i++) {
+        std::memcpy(distances->row(i), matrix.values + (size_t) i * n * sizeof(int32_t), n * sizeof(int32_t));
+    }
+    return distances;
+}
+
+
+/**
+ * @brief Parse a batch of updates, one "from,to,weight" line per edge, or
+ *        "from,to" to delete the edge. Blank lines are skipped.
+ *
+ * @param data Buffer holding the file.
+ * @param size Bytes in data.
+ * @param n_vertices Vertices of the matrix the updates apply to.
+ * @param updates Parsed updates, in the order of the file.
+ * @param error Reason the batch was rejected.
+ * @return false if a line is incomplete or names a vertex outside the matrix.
+ */
+bool parse_edge_updates(
+        const char* data, size_t size, int n_vertices,
+        std::vector<EdgeUpdate>& updates, std::string& error) {
+    updates.clear();
+    std::vector<LineSpan> lines = find_lines(data, size, 1);
+    for (size_t line = 0; line < lines.size(); line++) {
+        const char* cursor = data + lines[line].begin;
+        const char* end = data + lines[line].end;
+        EdgeUpdate update;
+        if (!scan_int(cursor, end, update.from)) { continue; }
+        if (!scan_int(cursor, end, update.to)) {
+            error = "Incomplete update on line " + std::to_string(line + 1);
+            return false;
+        }
+        if (!scan_int(cursor, end, update.weight)) { update.weight = INFINITY_INT; }
+        if (update.from < 0 || update.from >= n_vertices
+                || update.to < 0 || update.to >= n_vertices) {
+            error = "Vertex outside of the matrix on line " + std::to_string(line + 1);
+            return false;
+        }
+        updates.push_back(update);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Lower the edge (a, b) to weight w in a matrix of shortest distances
+ *        and update every pair whose shortest path now uses it:
+ *
+ *            d[i][j] = min(d[i][j], d[i][a] + w + d[b][j])
+ *
+ *        which is O(n^2) instead of the O(n^3) of a recomputation. Unless
+ *        the edge closes a negative cycle, row b and column a do not change,
+ *        so the rows are independent and split across the threads.
+ *
+ * @param distances Shortest distances, updated in place.
+ * @param update Inserted or lowered edge, a self loop or a weight above the
+ *        current distance of (a, b) changes nothing.
+ * @param n_threads Number of threads run updates the rows on.
+ * @param run Runs the row updates on the threads.
+ * @param changes Receives every changed entry, in row order.
+ * @return false if the edge closes a negative cycle, distances are unchanged.
+ */
+bool decrease_edge(
+        Matrix_2D* distances, EdgeUpdate update, int n_threads, ThreadRunner run,
+        std::vector<DistanceChange>& changes) {
+
+    int n = distances->get_dimension();
+    int a = update.from;
+    int b = update.to;
+    int weight = std::min(update.weight, INFINITY_INT);
+    if (a == b || weight >= distances->at(a, b)) { return true; } // self loops weigh 0
+    if (distances->at(b, a) < INFINITY_INT && (int64_t) distances->at(b, a) + weight < 0) {
+        return false;
+    }
+
+    std::vector<std::vector<DistanceChange>> found(n_threads);
+    const int* row_b = distances->row(b);
+    run([&](int thread_id) {
+        int start_row = (int64_t) n * thread_id / n_threads;
+        int end_row = (int64_t) n * (thread_id + 1) / n_threads;
+        for (int i = start_row; i < end_row; i++) {
+            int* row_i = distances->row(i);
+            if (row_i[a] >= INFINITY_INT) { continue; }
+            int64_t through_edge = (int64_t) row_i[a] + weight;
+            for (int j = 0; j < n; j++) {
+                if (row_b[j] >= INFINITY_INT || through_edge + row_b[j] >= row_i[j]) { continue; }
+                int through = (int) (through_edge + row_b[j]);
+                found[thread_id].push_back({i, j, row_i[j], through});
+                row_i[j] = through;
+            }
+        }
+    });
+    for (int t = 0; t < n_threads; t++) {
+        changes.insert(changes.end(), found[t].begin(), found[t].end());
+    }
+    return true;
+}
+
+
+/**
+ * @brief Johnson potentials read off a matrix of shortest distances: h[v] is
+ *        min(0, min_i d[i][v]), the distance to v from a virtual source with
+ *        a 0 weight edge to every vertex. They stay valid when a weight goes
+ *        up or an edge goes away, so no Bellman-Ford pass is needed.
+ */
+std::vector<int64_t> matrix_potentials(Matrix_2D* distances) {
+    int n = distances->get_dimension();
+    std::vector<int64_t> potentials(n, 0);
+    for (int i = 0; i < n; i++) {
+        const int* row = distances->row(i);
+        for (int v = 0; v < n; v++) { potentials[v] = std::min<int64_t>(potentials[v], row[v]); }
+    }
+    return potentials;
+}
+
+
+/**
+ * @brief Recompute the given rows with one single source search each (see
+ *        sssp_row), the threads claim rows from a shared counter.
+ *
+ * @param graph Graph the rows are recomputed on.
+ * @param distances Shortest distances, the rows are overwritten.
+ * @param rows Sources to recompute.
+ * @param potentials Johnson potentials, empty for non-negative weights.
+ * @param changes Receives every changed entry.
+ */
+void recompute_rows(
+        const CSRGraph& graph, Matrix_2D* distances, const std::vector<int>& rows,
+        const std::vector<int64_t>& potentials, int n_threads, ThreadRunner run,
+        std::vector<DistanceChange>& changes) {
+
+    int n = graph.get_n_vertices();
+    int n_buckets = dial_bucket_count(graph, potentials);
+    std::atomic<size_t> next_row(0);
+    std::vector<std::vector<DistanceChange>> found(n_threads);
+    run([&](int thread_id) {
+        SsspScratch scratch(n, !potentials.empty(), n_buckets);
+        std::vector<int> recomputed(n);
+        for (size_t r = next_row++; r < rows.size(); r = next_row++) {
+            int source = rows[r];
+            sssp_row(graph, source, recomputed.data(), potentials, scratch, (uint8_t*) NULL);
+            int* row = distances->row(source);
+            for (int j = 0; j < n; j++) {
+                if (recomputed[j] == row[j]) { continue; }
+                found[thread_id].push_back({source, j, row[j], recomputed[j]});
+                row[j] = recomputed[j];
+            }
+        }
+    });
+    for (int t = 0; t < n_threads; t++) {
+        changes.insert(changes.end(), found[t].begin(), found[t].end());
+    }
+}
+
+
+/**
+ * @brief Raise the edge (a, b) from old_weight, or delete it. Relaxation
+ *        cannot raise a distance, so the rows that can change are found and
+ *        recomputed on the new graph instead. Row i can only change if a
+ *        shortest path from i uses the edge, and then its prefix to b is
+ *        shortest too: d[i][a] + old_weight == d[i][b]. With non-negative
+ *        weights the row also keeps its distances if another edge (u, b) of
+ *        positive weight reaches b as fast, d[i][u] + w(u, b) == d[i][b]: a
+ *        shortest path to u cannot go through b, so it avoids the edge. Most
+ *        edges are on the only shortest paths of few sources, so few rows are
+ *        recomputed.
+ *
+ * @param distances Shortest distances of the graph before the update.
+ * @param graph Graph after the update.
+ * @param update Raised or deleted edge.
+ * @param old_weight Weight of the edge before the update.
+ * @param changes Receives every changed entry.
+ * @return Number of rows recomputed.
+ */
+int64_t increase_edge(
+        Matrix_2D* distances, const CSRGraph& graph, EdgeUpdate update, int old_weight,
+        int n_threads, ThreadRunner run, std::vector<DistanceChange>& changes) {
+
+    int n = distances->get_dimension();
+    int a = update.from;
+    int b = update.to;
+    bool negative = old_weight < 0 || has_negative_weights(graph);
+
+    // the other edges into b, a parallel scan of the rows would not pay off
+    // next to the searches
+    std::vector<std::pair<int, int>> other_edges;
+    for (int u = 0; u < n && !negative; u++) {
+        int weight = u == a || u == b ? INFINITY_INT : edge_weight(graph, u, b);
+        if (weight > 0 && weight < INFINITY_INT) { other_edges.push_back(std::make_pair(u, weight)); }
+    }
+
+    std::vector<int> rows;
+    for (int i = 0; i < n; i++) {
+        int distance_ia = distances->at(i, a);
+        int distance_ib = distances->at(i, b);
+        if (distance_ia >= INFINITY_INT || (int64_t) distance_ia + old_weight != distance_ib) {
+            continue;
+        }
+        bool other_path = false;
+        for (size_t e = 0; e < other_edges.size() && !other_path; e++) {
+            int distance_iu = distances->at(i, other_edges[e].first);
+            other_path = distance_iu < INFINITY_INT
+                && (int64_t) distance_iu + other_edges[e].second == distance_ib;
+        }
+        if (!other_path) { rows.push_back(i); }
+    }
+    if (rows.empty()) { return 0; }
+
+    std::vector<int64_t> potentials;
+    if (negative) { potentials = matrix_potentials(distances); }
+    recompute_rows(graph, distances, rows, potentials, n_threads, run, changes);
+    return rows.size();
+}
+
+
+/**
+ * @brief Apply a batch of edge updates in order. Insertions and decreases
+ *        are relaxed in O(n^2) (see decrease_edge). Increases and deletions
+ *        recompute the rows that used the edge (see increase_edge), which
+ *        needs the graph, and the graph is updated with every edge.
+ *
+ * @param graph Graph of the distances, updated with the edges. NULL if it is
+ *        not known: a weight is then only applied if it lowers the current
+ *        distance, and deletions are rejected.
+ * @param changes Every entry whose distance changed over the whole batch,
+ *        once, sorted by row and column, with its distance before the batch.
+ * @param rows_recomputed Incremented by the rows recomputed by increases.
+ * @param error Reason the batch stopped.
+ * @return false if an update closes a negative cycle or deletes an edge
+ *         without the graph, the updates before it stay applied.
+ */
+bool apply_edge_updates(
+        Matrix_2D* distances, CSRGraph* graph, const std::vector<EdgeUpdate>& updates,
+        int n_threads, ThreadRunner run, std::vector<DistanceChange>& changes,
+        int64_t& rows_recomputed, std::string& error) {
+
+    std::vector<DistanceChange> all_changes;
+    bool applied = true;
+    for (size_t u = 0; u < updates.size() && applied; u++) {
+        EdgeUpdate update = updates[u];
+        std::string edge = std::to_string(update.from) + "," + std::to_string(update.to);
+        update.weight = std::min(update.weight, INFINITY_INT);
+        if (graph == NULL) {
+            if (update.weight >= INFINITY_INT) {
+                error = "Deleting edge " + edge + " needs the graph";
+                applied = false;
+            } else if (!decrease_edge(distances, update, n_threads, run, all_changes)) {
+                error = "Edge " + edge + " closes a negative cycle";
+                applied = false;
+            }
+            continue;
+        }
+
+        int old_weight = edge_weight(*graph, update.from, update.to);
+        if (update.weight == old_weight) { continue; }
+        CSRGraph updated = with_edge_weight(*graph, update.from, update.to, update.weight);
+        if (update.weight < old_weight) {
+            if (!decrease_edge(distances, update, n_threads, run, all_changes)) {
+                error = "Edge " + edge + " closes a negative cycle";
+                applied = false;
+                continue;
+            }
+        } else if (update.from != update.to) { // self loops weigh 0
+            rows_recomputed += increase_edge(
+                distances, updated, update, old_weight, n_threads, run, all_changes
+            );
+        }
+        *graph = updated;
+    }
+
+    // an entry changed by several updates is reported once, an entry that
+    // went back to its old distance is not reported
+    std::stable_sort(all_changes.begin(), all_changes.end(),
+        [](const DistanceChange& x, const DistanceChange& y) {
+            return x.from != y.from ? x.from < y.from : x.to < y.to;
+        });
+    changes.clear();
+    for (const DistanceChange& change : all_changes) {
+        if (!changes.empty() && changes.back().from == change.from
+                && changes.back().to == change.to) {
+            changes.back().new_distance = change.new_distance;
+        } else {
+            changes.push_back(change);
+        }
+    }
+    changes.erase(
+        std::remove_if(changes.begin(), changes.end(),
+            [](const DistanceChange& change) { return change.old_distance == change.new_distance; }),
+        changes.end()
+    );
+    return applied;
+}
+
+
+/**
+ * @brief Print the changed entries, one "from,to,distance" line each,
+ *        formatted into one buffer and written with one write call.
+ *
+ * @return false if the write failed.
+ */
+bool print_distance_changes(const std::vector<DistanceChange>& changes) {
+    std::vector<char> buffer(changes.size() * 36 + 1);
+    char* out = buffer.data();
+    for (const DistanceChange& change : changes) {
+        out = format_int(out, change.from);
+        *out++ = ',';
+        out = format_int(out, change.to);
+        *out++ = ',';
+        out = format_int(out, change.new_distance);
+        *out++ = '\n';
+    }
+    std::cout << std::flush;
+    return write_all(1, buffer.data(), out - buffer.data());
+}
+
+#endif
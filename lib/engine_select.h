@@ -0,0 +1,187 @@
+#ifndef ENGINE_SELECT_H
+#define ENGINE_SELECT_H
+
+#include "../core/core_utils.h"
+#include "csr_graph.h"
+#include "path_utils.h"
+#include "sparse_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits.h>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// cost model of --engine auto, seconds per unit of work on one core. The
+// values were fitted on an AVX-512 core against graphs from 800 vertices at
+// 50% density to 2000 vertices with 5 edges each; only their ratios decide.
+#ifndef FW_SECONDS_PER_UPDATE
+#define FW_SECONDS_PER_UPDATE 9e-11   // one min-plus update of blocked FW
+#endif
+#ifndef SSSP_SECONDS_PER_EDGE
+#define SSSP_SECONDS_PER_EDGE 3e-9    // one edge relaxation of dijkstra/dial
+#endif
+#ifndef HEAP_SECONDS_PER_LEVEL
+#define HEAP_SECONDS_PER_LEVEL 8e-8   // one heap level of a settled vertex
+#endif
+#ifndef DIAL_SECONDS_PER_VERTEX
+#define DIAL_SECONDS_PER_VERTEX 4e-8  // one settled vertex of dial
+#endif
+
+
+/**
+ * @brief Shape of a graph as seen by the cost model. Self loops and edges of
+ *        weight INFINITY_INT or more are not counted, no engine uses them.
+ */
+struct GraphProfile {
+    int n_vertices;
+    int64_t n_edges;
+    int min_weight;
+    int max_weight;
+};
+
+
+GraphProfile profile_graph(const CSRGraph& graph) {
+    GraphProfile profile = {graph.get_n_vertices(), 0, INT_MAX, 0};
+    for (int u = 0; u < graph.get_n_vertices(); u++) {
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            int weight = graph.get_weight(e);
+            if (weight >= INFINITY_INT || graph.get_target(e) == u) { continue; }
+            profile.n_edges++;
+            profile.min_weight = std::min(profile.min_weight, weight);
+            profile.max_weight = std::max(profile.max_weight, weight);
+        }
+    }
+    if (profile.n_edges == 0) { profile.min_weight = 0; }
+    return profile;
+}
+
+
+/**
+ * @brief Physical memory of the machine in bytes, 0 if unknown.
+ */
+size_t physical_memory_bytes() {
+#ifdef _WIN32
+    return 0;
+#else
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && page_size > 0 ? (size_t) pages * page_size : 0;
+#endif
+}
+
+
+/**
+ * @brief Engine picked by --engine auto with the predictions behind it.
+ */
+struct EngineChoice {
+    std::string engine;
+    double predicted_seconds;
+    std::vector<std::pair<std::string, double>> candidates;
+    GraphProfile profile;
+    int n_cores;
+    size_t matrix_bytes;
+    size_t memory_bytes;
+};
+
+
+/**
+ * @brief Predict the run time of every engine that can run the graph and
+ *        pick the fastest:
+ *
+ *        blocked   n^3 min-plus updates, only for non-negative weights:
+ *                  its sums do not saturate at INFINITY_INT, a negative
+ *                  weight added to an unreachable distance would look
+ *                  reachable,
+ *        dijkstra  n sources of m relaxations and n log2(2 + m / n) heap
+ *                  levels, the lazy heap grows with the average degree
+ *                  rather than with n,
+ *        dial      n sources of m relaxations and n settled vertices, only
+ *                  for non-negative weights up to DIAL_MAX_WEIGHT.
+ *
+ *        Every engine spreads its work over the threads, up to the number of
+ *        cores. The Johnson potentials of negative weights are not counted,
+ *        the queue based Bellman-Ford usually takes a few passes over the
+ *        edges.
+ *
+ * @param graph Ingested graph.
+ * @param n_threads Threads the engine will run on.
+ * @param paths Whether the next hops of --paths are kept too.
+ */
+EngineChoice select_engine(const CSRGraph& graph, int n_threads, bool paths) {
+    EngineChoice choice;
+    choice.profile = profile_graph(graph);
+    int hardware_threads = std::thread::hardware_concurrency();
+    choice.n_cores = hardware_threads > 0 ? std::min(n_threads, hardware_threads) : n_threads;
+
+    double n = choice.profile.n_vertices;
+    double m = choice.profile.n_edges;
+    double sources = n / choice.n_cores;
+    if (choice.profile.min_weight >= 0) {
+        choice.candidates.push_back(std::make_pair(
+            std::string("blocked"), n * n * sources * FW_SECONDS_PER_UPDATE
+        ));
+    }
+    choice.candidates.push_back(std::make_pair(
+        std::string("dijkstra"),
+        sources * (m * SSSP_SECONDS_PER_EDGE + n * std::log2(2 + m / n) * HEAP_SECONDS_PER_LEVEL)
+    ));
+    if (choice.profile.min_weight >= 0 && choice.profile.max_weight <= DIAL_MAX_WEIGHT) {
+        choice.candidates.push_back(std::make_pair(
+            std::string("dial"),
+            sources * (m * SSSP_SECONDS_PER_EDGE + n * DIAL_SECONDS_PER_VERTEX)
+        ));
+    }
+
+    choice.engine = choice.candidates[0].first;
+    choice.predicted_seconds = choice.candidates[0].second;
+    for (auto candidate : choice.candidates) {
+        if (candidate.second < choice.predicted_seconds) {
+            choice.engine = candidate.first;
+            choice.predicted_seconds = candidate.second;
+        }
+    }
+
+    size_t entries = (size_t) choice.profile.n_vertices * choice.profile.n_vertices;
+    choice.matrix_bytes = entries * sizeof(int);
+    if (paths) { choice.matrix_bytes += entries * next_hop_width(choice.profile.n_vertices); }
+    choice.memory_bytes = physical_memory_bytes();
+    return choice;
+}
+
+
+/**
+ * @brief One line log of the choice, e.g. "Engine auto: dial, predicted
+ *        0.2s (blocked 0.7s, dijkstra 1s, dial 0.2s) for 2000 vertices,
+ *        10000 edges, weights 1 to 100 on 1 core, 15 MB of 64000 MB".
+ */
+std::string describe_engine_choice(const EngineChoice& choice) {
+    std::ostringstream line;
+    line << std::setprecision(3);
+    line << "Engine auto: " << choice.engine << ", predicted "
+         << choice.predicted_seconds << "s (";
+    for (size_t i = 0; i < choice.candidates.size(); i++) {
+        line << (i > 0 ? ", " : "") << choice.candidates[i].first << " "
+             << choice.candidates[i].second << "s";
+    }
+    line << ") for " << choice.profile.n_vertices << " vertices, "
+         << choice.profile.n_edges << " edges, weights " << choice.profile.min_weight
+         << " to " << choice.profile.max_weight << " on " << choice.n_cores
+         << (choice.n_cores == 1 ? " core, " : " cores, ") << (choice.matrix_bytes >> 20) << " MB";
+    if (choice.memory_bytes > 0) {
+        line << " of " << (choice.memory_bytes >> 20) << " MB";
+        if (choice.matrix_bytes > choice.memory_bytes) {
+            line << ", the matrix does not fit, see all_pairs_distributed";
+        }
+    }
+    return line.str();
+}
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef GRAPH_FORMAT_H
+#define GRAPH_FORMAT_H
+
+#include "csr_graph.h"
+#include "graph_ingest.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define GRAPH_MAGIC "APSPCSR"
+#define GRAPH_FORMAT_VERSION 1
+
+
+/**
+ * @brief Header of a binary graph file (little-endian). The header is
+ *        followed by the CSRGraph arrays exactly as they are laid out in
+ *        memory: n_vertices + 1 int64 offsets, n_edges int32 targets and
+ *        n_edges weights of weight_bytes bytes each (1, 2 or 4, the narrowest
+ *        that holds every weight). With 4 byte weights the file is used in
+ *        place, without copying.
+ */
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t weight_bytes;
+    uint64_t n_vertices;
+    uint64_t n_edges;
+    uint64_t offsets_checksum;
+    uint64_t targets_checksum;
+    uint64_t weights_checksum;
+    uint64_t header_checksum; // of every field above
+};
+
+static_assert(sizeof(GraphFileHeader) == 64, "the arrays must stay 8 byte aligned");
+
+
+/**
+ * @brief 64-bit checksum of a buffer, mixing 8 bytes at a time so that
+ *        verifying a file runs at memory bandwidth.
+ */
+uint64_t checksum64(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) { hash = (hash ^ bytes[i]) * 0x100000001b3ULL; }
+    return hash;
+}
+
+
+uint64_t header_checksum(const GraphFileHeader& header) {
+    return checksum64(&header, offsetof(GraphFileHeader, header_checksum));
+}
+
+
+/**
+ * @brief Check if a buffer starts with the binary graph magic, text graphs
+ *        only hold digits, commas and whitespace.
+ */
+bool is_binary_graph(const char* data, size_t size) {
+    return size >= sizeof(GraphFileHeader) && std::memcmp(data, GRAPH_MAGIC, 8) == 0;
+}
+
+
+/**
+ * @brief Narrowest weight width, 1, 2 or 4 bytes, holding every weight.
+ */
+uint32_t weight_width(const CSRGraph& graph) {
+    int min_weight = 0;
+    int max_weight = 0;
+    for (int64_t edge = 0; edge < graph.get_n_edges(); edge++) {
+        min_weight = std::min(min_weight, graph.get_weight(edge));
+        max_weight = std::max(max_weight, graph.get_weight(edge));
+    }
+    if (min_weight >= 0 && max_weight <= UCHAR_MAX) { return 1; }
+    if (min_weight >= 0 && max_weight <= USHRT_MAX) { return 2; }
+    return 4;
+}
+
+
+/**
+ * @brief Weights of the graph stored in weight_bytes bytes each.
+ */
+std::vector<char> pack_weights(const CSRGraph& graph, uint32_t weight_bytes) {
+    std::vector<char> packed(graph.get_n_edges() * weight_bytes);
+    for (int64_t edge = 0; edge < graph.get_n_edges(); edge++) {
+        if (weight_bytes == 1) {
+            ((uint8_t*) packed.data())[edge] = (uint8_t) graph.get_weight(edge);
+        } else if (weight_bytes == 2) {
+            ((uint16_t*) packed.data())[edge] = (uint16_t) graph.get_weight(edge);
+        } else {
+            ((int32_t*) packed.data())[edge] = graph.get_weight(edge);
+        }
+    }
+    return packed;
+}
+
+
+/**
+ * @brief Write a graph in the binary format.
+ *
+ * @param path Output file, overwritten.
+ * @param graph Graph to write.
+ * @param error Reason of the failure.
+ * @return false if the file could not be written.
+ */
+bool write_binary_graph(std::string path, const CSRGraph& graph, std::string& error) {
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, GRAPH_MAGIC, 8);
+    header.version = GRAPH_FORMAT_VERSION;
+    header.weight_bytes = weight_width(graph);
+    header.n_vertices = graph.get_n_vertices();
+    header.n_edges = graph.get_n_edges();
+
+    std::vector<char> weights = pack_weights(graph, header.weight_bytes);
+    size_t offsets_bytes = (header.n_vertices + 1) * sizeof(int64_t);
+    size_t targets_bytes = header.n_edges * sizeof(int);
+    header.offsets_checksum = checksum64(graph.get_offsets(), offsets_bytes);
+    header.targets_checksum = checksum64(graph.get_targets(), targets_bytes);
+    header.weights_checksum = checksum64(weights.data(), weights.size());
+    header.header_checksum = header_checksum(header);
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        error = "Unable to open file (" + path + ")";
+        return false;
+    }
+    output.write((const char*) &header, sizeof(header));
+    output.write((const char*) graph.get_offsets(), offsets_bytes);
+    output.write((const char*) graph.get_targets(), targets_bytes);
+    output.write(weights.data(), weights.size());
+    if (!output.good()) {
+        error = "Unable to write file (" + path + ")";
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Use a mapped binary graph file as a CSRGraph. The header, the
+ *        file size, the offsets and the targets are always validated; verify
+ *        also checks the checksums of the three arrays, which reads the whole
+ *        file.
+ *        Graphs with 4 byte weights point straight into the mapping and keep
+ *        it alive, narrower weights are widened into a new allocation.
+ *
+ * @param file Mapped binary graph file.
+ * @param verify Check the checksums of the arrays.
+ * @param graph Loaded graph.
+ * @param error Reason the file was rejected.
+ * @return false if the file is not a valid binary graph.
+ */
+bool read_binary_graph(
+        std::shared_ptr<MappedFile> file, bool verify, CSRGraph& graph, std::string& error) {
+
+    if (!is_binary_graph(file->data(), file->size())) {
+        error = "Not a binary graph";
+        return false;
+    }
+    GraphFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (header.header_checksum != header_checksum(header)) {
+        error = "Corrupted binary graph header";
+        return false;
+    }
+    if (header.version != GRAPH_FORMAT_VERSION) {
+        error = "Unsupported binary graph version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.weight_bytes != 1 && header.weight_bytes != 2 && header.weight_bytes != 4) {
+        error = "Unsupported weight width " + std::to_string(header.weight_bytes);
+        return false;
+    }
+    if (header.n_vertices > INT_MAX || header.n_edges > (uint64_t) INT64_MAX / 8) {
+        error = "Binary graph too large";
+        return false;
+    }
+
+    size_t offsets_bytes = (header.n_vertices + 1) * sizeof(int64_t);
+    size_t targets_bytes = header.n_edges * sizeof(int);
+    size_t weights_bytes = header.n_edges * header.weight_bytes;
+    if (file->size() != sizeof(header) + offsets_bytes + targets_bytes + weights_bytes) {
+        error = "Truncated binary graph";
+        return false;
+    }
+
+    const char* offsets_data = file->data() + sizeof(header);
+    const char* targets_data = offsets_data + offsets_bytes;
+    const char* weights_data = targets_data + targets_bytes;
+    if (verify && (checksum64(offsets_data, offsets_bytes) != header.offsets_checksum
+                   || checksum64(targets_data, targets_bytes) != header.targets_checksum
+                   || checksum64(weights_data, weights_bytes) != header.weights_checksum)) {
+        error = "Binary graph checksum mismatch";
+        return false;
+    }
+
+    // the engines trust the offsets, so they are checked even without verify
+    const int64_t* offsets = (const int64_t*) offsets_data;
+    for (uint64_t vertex = 0; vertex < header.n_vertices; vertex++) {
+        if (offsets[vertex] > offsets[vertex + 1]) {
+            error = "Invalid binary graph offsets";
+            return false;
+        }
+    }
+    if (offsets[0] != 0 || offsets[header.n_vertices] != (int64_t) header.n_edges) {
+        error = "Invalid binary graph offsets";
+        return false;
+    }
+
+    // and index with the targets, which lower_bound expects sorted per vertex
+    // (strictly, the parallel edges are collapsed)
+    const int* targets = (const int*) targets_data;
+    for (uint64_t vertex = 0; vertex < header.n_vertices; vertex++) {
+        for (int64_t edge = offsets[vertex]; edge < offsets[vertex + 1]; edge++) {
+            if (targets[edge] < 0 || (uint64_t) targets[edge] >= header.n_vertices
+                    || (edge > offsets[vertex] && targets[edge] <= targets[edge - 1])) {
+                error = "Invalid binary graph targets";
+                return false;
+            }
+        }
+    }
+
+    // the mapping stays alive as long as any graph points into it
+    std::shared_ptr<const char> storage(file, file->data());
+    const int* weights = (const int*) weights_data;
+    if (header.weight_bytes != 4) {
+        int* widened = new int[header.n_edges];
+        for (uint64_t edge = 0; edge < header.n_edges; edge++) {
+            widened[edge] = header.weight_bytes == 1
+                ? ((const uint8_t*) weights_data)[edge]
+                : ((const uint16_t*) weights_data)[edge];
+        }
+        storage = std::shared_ptr<const char>(
+            (const char*) widened, [file](const char* p) { delete[] (const int*) p; }
+        );
+        weights = widened;
+    }
+
+    graph = CSRGraph(
+        header.n_vertices, header.n_edges, storage,
+        offsets, (const int*) targets_data, weights
+    );
+    return true;
+}
+
+
+/**
+ * @brief Write a graph in the text format read by the all_pairs binaries, one
+ *        line of target,weight pairs per vertex. Empty lines are skipped when
+ *        reading, so a vertex without edges gets a 0 weight self loop, which
+ *        does not change any distance.
+ */
+bool write_text_graph(std::string path, const CSRGraph& graph, std::string& error) {
+    std::ofstream output(path, std::ios::trunc);
+    if (!output.is_open()) {
+        error = "Unable to open file (" + path + ")";
+        return false;
+    }
+    std::string line;
+    for (int vertex = 0; vertex < graph.get_n_vertices(); vertex++) {
+        line.clear();
+        for (int64_t edge = graph.edges_begin(vertex); edge < graph.edges_end(vertex); edge++) {
+            if (!line.empty()) { line += ','; }
+            line += std::to_string(graph.get_target(edge));
+            line += ',';
+            line += std::to_string(graph.get_weight(edge));
+        }
+        if (line.empty()) { line = std::to_string(vertex) + ",0"; }
+        output << line << '\n';
+    }
+    if (!output.good()) {
+        error = "Unable to write file (" + path + ")";
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Load a graph file in either format, detected from its first bytes.
+ *        A binary graph is used straight from the mapping, a text graph is
+ *        parsed into a CSRGraph on n_threads threads.
+ *
+ * @param file Mapped graph file.
+ * @param n_threads Threads used to parse a text graph.
+ * @param graph Loaded graph, empty if the file holds no vertices.
+ * @param error Reason the file was rejected.
+ * @return false if the file is not a valid graph.
+ */
+bool load_graph(
+        std::shared_ptr<MappedFile> file, int n_threads, CSRGraph& graph, std::string& error) {
+
+    if (is_binary_graph(file->data(), file->size())) {
+        return read_binary_graph(file, false, graph, error);
+    }
+    std::vector<LineSpan> lines = find_lines(file->data(), file->size(), n_threads);
+    if (!build_csr_graph(file->data(), lines, n_threads, graph)) {
+        error = "Edge to a vertex outside of the graph";
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef GRAPH_INGEST_H
+#define GRAPH_INGEST_H
+
+#include "graph_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * @brief Read-only view of a whole file. The file is mapped into memory
+ *        rather than copied, so pages are loaded on demand and shared with the
+ *        page cache (and between MPI ranks on the same node). On Windows the
+ *        file is read into a buffer instead.
+ */
+class MappedFile {
+
+private:
+    const char* contents;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+
+public:
+    MappedFile(std::string path) : contents(NULL), length(0), opened(false) {
+#ifdef _WIN32
+        std::ifstream input(path, std::ios::binary);
+        if (!input.is_open()) { return; }
+        buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        contents = buffer.data();
+        length = buffer.size();
+        opened = true;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return; }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+            close(fd);
+            return;
+        }
+        length = file_stat.st_size;
+        if (length > 0) {
+            void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                length = 0;
+                return;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            contents = (const char*) mapped;
+        }
+        close(fd); // the mapping stays valid
+        opened = true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (contents != NULL) { munmap((void*) contents, length); }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() { return opened; }
+    const char* data() { return contents; }
+    size_t size() { return length; }
+};
+
+
+/**
+ * @brief Characters [begin, end) of one line, without its newline.
+ */
+struct LineSpan {
+    size_t begin;
+    size_t end;
+};
+
+
+/**
+ * @brief Threads used to ingest a graph when the caller has no preference.
+ */
+int ingest_threads() {
+    int n_threads = std::thread::hardware_concurrency();
+    return n_threads > 0 ? n_threads : 1;
+}
+
+
+/**
+ * @brief Run fn(thread_id) on n_threads short lived threads and wait for
+ *        them, the calling thread runs thread 0.
+ */
+template <typename Fn>
+void run_ingest_threads(int n_threads, Fn fn) {
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n_threads; i++) { threads.emplace_back(fn, i); }
+    fn(0);
+    for (std::thread& thread : threads) { thread.join(); }
+}
+
+
+/**
+ * @brief Find the non-empty lines of a buffer, matching std::getline
+ *        followed by dropping empty lines. The buffer is cut into n_threads
+ *        byte ranges and every thread collects the lines that start in its
+ *        range, a line may run past the end of the range.
+ *
+ * @param data Buffer holding the file.
+ * @param size Size of the buffer.
+ * @param n_threads Number of threads scanning the buffer.
+ * @return Lines in file order, line i holds the edges of vertex i.
+ */
+std::vector<LineSpan> find_lines(const char* data, size_t size, int n_threads) {
+    if (size == 0) { return std::vector<LineSpan>(); }
+    n_threads = std::max(1, (int) std::min<size_t>(n_threads, size));
+    std::vector<std::vector<LineSpan>> found(n_threads);
+
+    run_ingest_threads(n_threads, [&](int thread_id) {
+        size_t range_start = size * thread_id / n_threads;
+        size_t range_end = size * (thread_id + 1) / n_threads;
+
+        // first line starting at or after range_start
+        size_t line_start = range_start;
+        if (line_start > 0 && data[line_start - 1] != '\n') {
+            const char* newline = (const char*) std::memchr(
+                data + line_start, '\n', size - line_start
+            );
+            line_start = newline == NULL ? size : newline - data + 1;
+        }
+
+        while (line_start < range_end) {
+            const char* newline = (const char*) std::memchr(
+                data + line_start, '\n', size - line_start
+            );
+            size_t line_end = newline == NULL ? size : newline - data;
+            if (line_end > line_start) { found[thread_id].push_back({line_start, line_end}); }
+            line_start = line_end + 1;
+        }
+    });
+
+    std::vector<LineSpan> lines;
+    for (std::vector<LineSpan>& part : found) {
+        lines.insert(lines.end(), part.begin(), part.end());
+    }
+    return lines;
+}
+
+
+/**
+ * @brief Vertices [start_vertex, end_vertex) parsed by one of n_threads
+ *        threads. The ranges hold about the same number of bytes, so a few
+ *        very long lines do not end up on the same thread.
+ *
+ * @param lines Lines of the buffer, see find_lines.
+ */
+void vertex_range(
+        const std::vector<LineSpan>& lines, int thread_id, int n_threads,
+        int* start_vertex, int* end_vertex) {
+
+    int n = lines.size();
+    size_t first_byte = n == 0 ? 0 : lines.front().begin;
+    size_t total_bytes = n == 0 ? 0 : lines.back().end - first_byte;
+    auto first_vertex = [&](int id) {
+        if (id == 0) { return 0; }
+        if (id == n_threads) { return n; }
+        size_t boundary = first_byte + total_bytes * id / n_threads;
+        return (int) (std::lower_bound(
+            lines.begin(), lines.end(), boundary,
+            [](const LineSpan& line, size_t offset) { return line.begin < offset; }
+        ) - lines.begin());
+    };
+    *start_vertex = first_vertex(thread_id);
+    *end_vertex = first_vertex(thread_id + 1);
+}
+
+#endif
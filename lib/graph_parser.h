@@ -0,0 +1,116 @@
+#ifndef GRAPH_PARSER_H
+#define GRAPH_PARSER_H
+
+#include "Edge.h"
+#include <cstring>
+#include <limits.h>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Read the next integer of a comma separated line, the same way
+ *        `stream >> value` followed by skipping one ',' would: leading
+ *        whitespace and an optional sign are accepted, anything else that is
+ *        not a digit ends the line. Values outside of int saturate.
+ *
+ * @param cursor Position in the line, moved past the value and its comma.
+ * @param end One past the last character of the line.
+ * @param value Parsed integer.
+ * @return false once there is no further integer on the line.
+ */
+inline bool scan_int(const char*& cursor, const char* end, int& value) {
+    const char* p = cursor;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) { p++; }
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || (unsigned) (*p - '0') > 9) { return false; }
+
+    long long magnitude = 0;
+    for (; p < end && (unsigned) (*p - '0') <= 9; p++) {
+        if (magnitude <= INT_MAX) { magnitude = magnitude * 10 + (*p - '0'); }
+    }
+    if (negative) {
+        value = magnitude > (long long) INT_MAX + 1 ? INT_MIN : (int) -magnitude;
+    } else {
+        value = magnitude > INT_MAX ? INT_MAX : (int) magnitude;
+    }
+
+    if (p < end && *p == ',') { p++; }
+    cursor = p;
+    return true;
+}
+
+
+/**
+ * @brief Scan a csv line of alternating output vertices and weights straight
+ *        out of the buffer, without copying it or storing the values. A
+ *        trailing output vertex without a weight is ignored.
+ *
+ * @param begin First character of the line.
+ * @param end One past the last character of the line.
+ * @param emit Called as emit(output_vertex, weight) for every edge.
+ * @return Number of edges emitted.
+ */
+template <typename Emit>
+inline long parse_edge_line(const char* begin, const char* end, Emit emit) {
+    long n_edges = 0;
+    int output_vertex;
+    int weight;
+    while (scan_int(begin, end, output_vertex) && scan_int(begin, end, weight)) {
+        emit(output_vertex, weight);
+        n_edges++;
+    }
+    return n_edges;
+}
+
+
+/**
+ * @brief Parse the csv line of input_vertex from a buffer and append its
+ *        edges to vertex_edges.
+ *
+ * @param vertex_edges Edges of input_vertex.
+ * @param input_vertex Input vertex for the directed edges.
+ * @param begin First character of the line.
+ * @param end One past the last character of the line.
+ */
+void parse_edges(
+        std::vector<Edge>& vertex_edges, int input_vertex, const char* begin, const char* end) {
+
+    // every edge takes two commas, reserve once instead of growing
+    long n_commas = 0;
+    for (const char* p = begin; (p = (const char*) std::memchr(p, ',', end - p)) != NULL; p++) {
+        n_commas++;
+    }
+    vertex_edges.reserve(vertex_edges.size() + n_commas / 2 + 1);
+
+    parse_edge_line(begin, end, [&](int output_vertex, int weight) {
+        vertex_edges.push_back(Edge(input_vertex, output_vertex, weight));
+    });
+}
+
+
+/**
+ * @brief Given a csv line, seperate them such that the ith character is
+ *        the output vertex and the i+1th character is the wieght of the edge.
+ *
+ * @param edges A map of input vertices with a key of edges.
+ * @param input_vertex Input vertex for the directed edge.
+ * @param csv_line String of output vertices and weights.
+ */
+void generate_edges(
+        std::map<int, std::vector<Edge>>& edges,
+        int input_vertex,
+        const std::string& csv_line) {
+
+    parse_edges(
+        edges[input_vertex], input_vertex, csv_line.data(), csv_line.data() + csv_line.size()
+    );
+}
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef MATRIX_FORMAT_H
+#define MATRIX_FORMAT_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "graph_ingest.h"
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// upper bound of the bytes held by every thread's buffer in one round
+#ifndef FORMAT_BUFFER_BYTES
+#define FORMAT_BUFFER_BYTES (1 << 22)
+#endif
+
+
+/**
+ * @brief Runs fn(thread_id) once on every formatting thread and waits for
+ *        them, e.g. ThreadPool::run or short_lived_threads.
+ */
+typedef std::function<void(std::function<void(int)>)> ThreadRunner;
+
+
+/**
+ * @brief Runner starting n_threads short lived threads, see run_ingest_threads.
+ */
+ThreadRunner short_lived_threads(int n_threads) {
+    return [n_threads](std::function<void(int)> fn) { run_ingest_threads(n_threads, fn); };
+}
+
+
+static const char DIGIT_PAIRS[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+
+inline int count_digits(uint32_t value) {
+    int digits = 1;
+    while (true) {
+        if (value < 10) { return digits; }
+        if (value < 100) { return digits + 1; }
+        if (value < 1000) { return digits + 2; }
+        if (value < 10000) { return digits + 3; }
+        value /= 10000;
+        digits += 4;
+    }
+}
+
+
+/**
+ * @brief Write the decimal digits of value at out, like std::to_chars (C++17),
+ *        two digits at a time from the back.
+ *
+ * @return One past the last character written, at most 11 characters.
+ */
+inline char* format_int(char* out, int value) {
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    if (value < 0) { *out++ = '-'; }
+    char* end = out + count_digits(magnitude);
+    char* cursor = end;
+    while (magnitude >= 100) {
+        const char* pair = DIGIT_PAIRS + (magnitude % 100) * 2;
+        magnitude /= 100;
+        *--cursor = pair[1];
+        *--cursor = pair[0];
+    }
+    if (magnitude >= 10) {
+        const char* pair = DIGIT_PAIRS + magnitude * 2;
+        *--cursor = pair[1];
+        *--cursor = pair[0];
+    } else {
+        *--cursor = '0' + magnitude;
+    }
+    return end;
+}
+
+
+/**
+ * @brief Largest number of characters format_row writes for a row.
+ */
+size_t max_row_bytes(int columns) {
+    return 11 + 3 + (size_t) columns * 12 + 1;
+}
+
+
+/**
+ * @brief Format one row in the layout of Matrix_2D::print_matrix.
+ *
+ * @return One past the last character written.
+ */
+inline char* format_row(char* out, int row, const int* values, int columns) {
+    out = format_int(out, row);
+    *out++ = ' ';
+    *out++ = '|';
+    *out++ = '\t';
+    for (int j = 0; j < columns; j++) {
+        if (values[j] >= INFINITY_INT) {
+            *out++ = 'I';
+            *out++ = 'N';
+            *out++ = 'F';
+            *out++ = ' ';
+        } else {
+            out = format_int(out, values[j]);
+            *out++ = '\t';
+        }
+    }
+    *out++ = '\n';
+    return out;
+}
+
+
+/**
+ * @brief Write the whole buffer to a file descriptor, retrying short writes
+ *        and writes interrupted by a signal.
+ */
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned int) std::min<size_t>(size, 1 << 30));
+#else
+        ssize_t written = write(fd, data, size);
+#endif
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written <= 0) { return false; }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Write the matrix in the layout of Matrix_2D::print_matrix. The rows
+ *        are formatted in rounds: every thread formats a contiguous run of
+ *        rows into its own buffer, then the buffers are written in order with
+ *        one write call each. Anything buffered by std::cout must be flushed
+ *        before writing to its descriptor.
+ *
+ * @param distances Matrix to write.
+ * @param fd Descriptor to write to, e.g. 1 for stdout.
+ * @param n_threads Number of threads run formats on.
+ * @param run Runs the formatting on the threads.
+ * @return false if a write failed.
+ */
+bool write_matrix_text(Matrix_2D* distances, int fd, int n_threads, ThreadRunner run) {
+    int rows = distances->get_dimension();
+    int columns = distances->get_columns();
+    size_t row_bytes = max_row_bytes(columns);
+
+    std::vector<char> header(4 + (size_t) columns * 12 + 2);
+    char* out = header.data();
+    *out++ = ' ';
+    *out++ = ' ';
+    *out++ = '|';
+    *out++ = '\t';
+    for (int j = 0; j < columns; j++) {
+        out = format_int(out, j);
+        *out++ = '\t';
+    }
+    *out++ = '\n';
+    *out++ = '\n';
+    if (!write_all(fd, header.data(), out - header.data())) { return false; }
+
+    int thread_rows = std::max<int>(1, FORMAT_BUFFER_BYTES / row_bytes);
+    std::vector<std::vector<char>> buffers(n_threads);
+    std::vector<size_t> lengths(n_threads, 0);
+    bool written = true;
+
+    for (int first_row = 0; first_row < rows && written; first_row += thread_rows * n_threads) {
+        run([&](int thread_id) {
+            int start = std::min(rows, first_row + thread_id * thread_rows);
+            int end = std::min(rows, start + thread_rows);
+            std::vector<char>& buffer = buffers[thread_id];
+            if (buffer.size() < (end - start) * row_bytes) { buffer.resize((end - start) * row_bytes); }
+            char* cursor = buffer.data();
+            for (int i = start; i < end; i++) {
+                cursor = format_row(cursor, i, distances->row(i), columns);
+            }
+            lengths[thread_id] = cursor - buffer.data();
+        });
+        for (int t = 0; t < n_threads && written; t++) {
+            written = write_all(fd, buffers[t].data(), lengths[t]);
+        }
+    }
+    return written;
+}
+
+
+/**
+ * @brief Write the text matrix to a new file, see write_matrix_text.
+ *
+ * @param prefix Written before the matrix, e.g. "Final matrix\n".
+ * @return false if the file could not be written.
+ */
+bool write_matrix_text_file(
+        Matrix_2D* distances, std::string path, std::string prefix,
+        int n_threads, ThreadRunner run) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) { return false; }
+    bool written = write_all(fd, prefix.data(), prefix.size())
+        && write_matrix_text(distances, fd, n_threads, run);
+#ifdef _WIN32
+    written &= _close(fd) == 0;
+#else
+    written &= close(fd) == 0;
+#endif
+    return written;
+}
+
+#endif
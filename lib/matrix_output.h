@@ -0,0 +1,232 @@
+#ifndef MATRIX_OUTPUT_H
+#define MATRIX_OUTPUT_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "graph_ingest.h"
+#include "matrix_format.h"
+#include "path_utils.h"
+#include <cstring>
+#include <fstream>
+#include <limits.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#define DEFAULT_OUTPUT_FORMAT "text"
+#define MATRIX_MAGIC "APSPMAT"
+#define MATRIX_FORMAT_VERSION 1
+
+
+/**
+ * @brief Header of a binary distance matrix file (little-endian). The
+ *        rows x columns int32 distances follow at data_offset in row-major
+ *        order without padding, so entry (i, j) is the int at byte
+ *        data_offset + (i * columns + j) * 4 and a consumer can mmap the file
+ *        and index it directly. Unreachable pairs hold the infinity value.
+ */
+struct MatrixFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t element_bytes;
+    uint64_t rows;
+    uint64_t columns;
+    int32_t infinity;
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t padding[2];
+};
+
+static_assert(sizeof(MatrixFileHeader) == 64, "the distances must stay 8 byte aligned");
+
+
+MatrixFileHeader matrix_file_header(
+        uint64_t rows, uint64_t columns,
+        uint32_t element_bytes = sizeof(int32_t), int32_t infinity = INFINITY_INT) {
+    MatrixFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MATRIX_MAGIC, 8);
+    header.version = MATRIX_FORMAT_VERSION;
+    header.element_bytes = element_bytes;
+    header.rows = rows;
+    header.columns = columns;
+    header.infinity = infinity;
+    header.data_offset = sizeof(MatrixFileHeader);
+    return header;
+}
+
+
+bool is_output_format(std::string format) {
+    return format == "text" || format == "binary";
+}
+
+
+/**
+ * @brief Write the distances as a binary matrix file, one row at a time
+ *        straight from the matrix, without its row padding.
+ *
+ * @return false if the file could not be written.
+ */
+bool write_binary_matrix(Matrix_2D* distances, std::string path) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) { return false; }
+
+    MatrixFileHeader header = matrix_file_header(
+        distances->get_dimension(), distances->get_columns()
+    );
+    output.write((const char*) &header, sizeof(header));
+    for (int i = 0; i < distances->get_dimension(); i++) {
+        output.write((const char*) distances->row(i), distances->get_columns() * sizeof(int));
+    }
+    return output.good();
+}
+
+
+/**
+ * @brief Print the result, or write it to output_file when one is given.
+ *        Text is formatted on n_threads threads, see write_matrix_text.
+ *
+ * @param distances Shortest path distances.
+ * @param output_file File receiving the result, empty to print it.
+ * @param output_format text (the printed layout) or binary (MatrixFileHeader).
+ * @param n_threads Number of threads run formats the text on.
+ * @param run Runs the formatting on the threads.
+ * @return false if the result could not be written, to the file or stdout.
+ */
+bool output_matrix(
+        Matrix_2D* distances, std::string output_file, std::string output_format,
+        int n_threads, ThreadRunner run) {
+    if (output_file.empty()) {
+        std::cout << "Final matrix\n" << std::flush;
+        return write_matrix_text(distances, 1, n_threads, run);
+    }
+
+    bool written = output_format == "binary"
+        ? write_binary_matrix(distances, output_file)
+        : write_matrix_text_file(distances, output_file, "Final matrix\n", n_threads, run);
+    if (!written) { std::cout << "Unable to write file (" << output_file << ")" << std::endl; }
+    return written;
+}
+
+/**
+ * @brief A binary matrix file mapped into memory, see MatrixFileHeader.
+ */
+struct MappedMatrix {
+    std::shared_ptr<MappedFile> file;
+    MatrixFileHeader header;
+    const char* values; // rows x columns elements of header.element_bytes
+};
+
+
+/**
+ * @brief Map a binary matrix file written with --outputFormat binary. The
+ *        header and the file size are validated, the values are used in place.
+ *
+ * @param path Matrix file.
+ * @param matrix Mapped matrix.
+ * @param error Reason the file was rejected.
+ * @return false if the file is not a valid binary matrix.
+ */
+bool map_binary_matrix(std::string path, MappedMatrix& matrix, std::string& error) {
+    matrix.file = std::make_shared<MappedFile>(path);
+    if (!matrix.file->is_open()) {
+        error = "Unable to open file (" + path + ")";
+        return false;
+    }
+    MatrixFileHeader& header = matrix.header;
+    if (matrix.file->size() < sizeof(header)
+            || std::memcmp(matrix.file->data(), MATRIX_MAGIC, 8) != 0) {
+        error = "Not a binary matrix (" + path + ")";
+        return false;
+    }
+    std::memcpy(&header, matrix.file->data(), sizeof(header));
+    if (header.version != MATRIX_FORMAT_VERSION) {
+        error = "Unsupported binary matrix version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.element_bytes != 1 && header.element_bytes != 2 && header.element_bytes != 4) {
+        error = "Unsupported element width " + std::to_string(header.element_bytes);
+        return false;
+    }
+    if (header.rows > INT_MAX || header.columns > INT_MAX || header.data_offset < sizeof(header)
+            || matrix.file->size() < header.data_offset
+            || matrix.file->size() - header.data_offset
+               != header.rows * header.columns * header.element_bytes) {
+        error = "Truncated binary matrix (" + path + ")";
+        return false;
+    }
+    matrix.values = matrix.file->data() + header.data_offset;
+    return true;
+}
+
+
+/**
+ * @brief File the next hops of --paths are written to next to the distances.
+ */
+std::string next_hops_path(std::string output_file) {
+    return output_file + ".next";
+}
+
+
+/**
+ * @brief Write the next hops as a binary matrix file: a MatrixFileHeader
+ *        whose element_bytes is the width of a hop and whose infinity is the
+ *        all-bits-set "no path" value of that width, then the hops row-major.
+ *
+ * @return false if the file could not be written.
+ */
+bool write_binary_next_hops(const NextHopMatrix* next_hops, std::string path) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) { return false; }
+
+    int width = next_hops->get_width();
+    int32_t no_path = width == 4 ? -1 : (int32_t) ((1u << (8 * width)) - 1);
+    MatrixFileHeader header = matrix_file_header(
+        next_hops->get_dimension(), next_hops->get_dimension(), width, no_path
+    );
+    output.write((const char*) &header, sizeof(header));
+    output.write(
+        next_hops->data(), (size_t) next_hops->get_dimension() * next_hops->get_dimension() * width
+    );
+    return output.good();
+}
+
+
+/**
+ * @brief Print the next hops of --paths after the distances, or write them
+ *        to next_hops_path(output_file). The text layout is the one of the
+ *        distances with INF where there is no path.
+ *
+ * @return false if the next hops could not be written, to the file or stdout.
+ */
+bool output_next_hops(
+        const NextHopMatrix* next_hops, std::string output_file, std::string output_format,
+        int n_threads, ThreadRunner run) {
+    std::string path = next_hops_path(output_file);
+    if (!output_file.empty() && output_format == "binary") {
+        bool written = write_binary_next_hops(next_hops, path);
+        if (!written) { std::cout << "Unable to write file (" << path << ")" << std::endl; }
+        return written;
+    }
+
+    int n = next_hops->get_dimension();
+    Matrix_2D hops(n);
+    run([&](int thread_id) {
+        for (int i = thread_id; i < n; i += n_threads) {
+            int* row = hops.row(i);
+            for (int j = 0; j < n; j++) {
+                int hop = next_hops->next_hop(i, j);
+                row[j] = hop < 0 ? INFINITY_INT : hop;
+            }
+        }
+    });
+    if (output_file.empty()) {
+        std::cout << "Next hops\n" << std::flush;
+        return write_matrix_text(&hops, 1, n_threads, run);
+    }
+    bool written = write_matrix_text_file(&hops, path, "Next hops\n", n_threads, run);
+    if (!written) { std::cout << "Unable to write file (" << path << ")" << std::endl; }
+    return written;
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef MIN_PLUS_H
+#define MIN_PLUS_H
+
+#include "../core/core_utils.h"
+#include <algorithm>
+#include <stddef.h>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MIN_PLUS_X86 1
+#endif
+
+
+/**
+ * @brief Min-plus update of a rows x cols block C through depth pivots:
+ *
+ *            for k < depth, i < rows, j < cols:
+ *                C[i][j] = min(C[i][j], A[i][k] + B[k][j])
+ *
+ *        A, B and C all point into matrices with the same row stride and may
+ *        overlap (every Floyd-Warshall engine updates in place). Rows whose
+ *        A[i][k] is INFINITY_INT are skipped, B[k][j] is not checked. With
+ *        entries from 0 to INFINITY_INT the sum cannot overflow and a sum
+ *        through an infinite B[k][j] is at least INFINITY_INT, so it never
+ *        replaces C[i][j]. A negative A[i][k] would turn an infinite B[k][j]
+ *        into a finite looking sum: negative weights need Johnson's
+ *        reweighting (dijkstra) instead of these kernels.
+ */
+typedef void (*min_plus_update_fn)(
+    int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth
+);
+
+
+inline void min_plus_update_scalar(
+        int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth) {
+
+    for (int k = 0; k < depth; k++) {
+        const int* b_row = b + k * stride;
+        for (int i = 0; i < rows; i++) {
+            int distance_ik = a[i * stride + k];
+            if (distance_ik >= INFINITY_INT) { continue; }
+            int* c_row = c + i * stride;
+            for (int j = 0; j < cols; j++) {
+                c_row[j] = std::min(c_row[j], distance_ik + b_row[j]);
+            }
+        }
+    }
+}
+
+
+#ifdef MIN_PLUS_X86
+
+__attribute__((target("sse4.1")))
+void min_plus_update_sse41(
+        int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth) {
+
+    for (int k = 0; k < depth; k++) {
+        const int* b_row = b + k * stride;
+        for (int i = 0; i < rows; i++) {
+            int distance_ik = a[i * stride + k];
+            if (distance_ik >= INFINITY_INT) { continue; }
+            int* c_row = c + i * stride;
+            __m128i broadcast_ik = _mm_set1_epi32(distance_ik);
+            int j = 0;
+            for (; j + 4 <= cols; j += 4) {
+                __m128i through_k = _mm_add_epi32(
+                    broadcast_ik, _mm_loadu_si128((const __m128i*) (b_row + j))
+                );
+                __m128i current = _mm_loadu_si128((const __m128i*) (c_row + j));
+                _mm_storeu_si128((__m128i*) (c_row + j), _mm_min_epi32(current, through_k));
+            }
+            for (; j < cols; j++) {
+                c_row[j] = std::min(c_row[j], distance_ik + b_row[j]);
+            }
+        }
+    }
+}
+
+
+__attribute__((target("avx2")))
+void min_plus_update_avx2(
+        int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth) {
+
+    for (int k = 0; k < depth; k++) {
+        const int* b_row = b + k * stride;
+        for (int i = 0; i < rows; i++) {
+            int distance_ik = a[i * stride + k];
+            if (distance_ik >= INFINITY_INT) { continue; }
+            int* c_row = c + i * stride;
+            __m256i broadcast_ik = _mm256_set1_epi32(distance_ik);
+            int j = 0;
+            for (; j + 8 <= cols; j += 8) {
+                __m256i through_k = _mm256_add_epi32(
+                    broadcast_ik, _mm256_loadu_si256((const __m256i*) (b_row + j))
+                );
+                __m256i current = _mm256_loadu_si256((const __m256i*) (c_row + j));
+                _mm256_storeu_si256((__m256i*) (c_row + j), _mm256_min_epi32(current, through_k));
+            }
+            for (; j < cols; j++) {
+                c_row[j] = std::min(c_row[j], distance_ik + b_row[j]);
+            }
+        }
+    }
+}
+
+
+__attribute__((target("avx512f")))
+void min_plus_update_avx512(
+        int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth) {
+
+    for (int k = 0; k < depth; k++) {
+        const int* b_row = b + k * stride;
+        for (int i = 0; i < rows; i++) {
+            int distance_ik = a[i * stride + k];
+            if (distance_ik >= INFINITY_INT) { continue; }
+            int* c_row = c + i * stride;
+            __m512i broadcast_ik = _mm512_set1_epi32(distance_ik);
+            int j = 0;
+            for (; j + 16 <= cols; j += 16) {
+                __m512i through_k = _mm512_add_epi32(broadcast_ik, _mm512_loadu_si512(b_row + j));
+                __m512i current = _mm512_loadu_si512(c_row + j);
+                _mm512_storeu_si512(c_row + j, _mm512_min_epi32(current, through_k));
+            }
+            if (j < cols) { // masked tail instead of a scalar loop
+                __mmask16 tail = (__mmask16) ((1u << (cols - j)) - 1);
+                __m512i through_k = _mm512_add_epi32(
+                    broadcast_ik, _mm512_maskz_loadu_epi32(tail, b_row + j)
+                );
+                __m512i current = _mm512_maskz_loadu_epi32(tail, c_row + j);
+                _mm512_mask_storeu_epi32(c_row + j, tail, _mm512_min_epi32(current, through_k));
+            }
+        }
+    }
+}
+
+#endif
+
+
+/**
+ * @brief Check if the CPU we are running on supports a kernel.
+ *
+ * @param name One of scalar, sse4.1, avx2, avx512.
+ */
+bool min_plus_kernel_supported(std::string name) {
+    if (name == "scalar") { return true; }
+#ifdef MIN_PLUS_X86
+    __builtin_cpu_init();
+    if (name == "sse4.1") { return __builtin_cpu_supports("sse4.1"); }
+    if (name == "avx2") { return __builtin_cpu_supports("avx2"); }
+    if (name == "avx512") { return __builtin_cpu_supports("avx512f"); }
+#endif
+    return false;
+}
+
+
+min_plus_update_fn min_plus_kernel_by_name(std::string name) {
+#ifdef MIN_PLUS_X86
+    if (name == "sse4.1") { return min_plus_update_sse41; }
+    if (name == "avx2") { return min_plus_update_avx2; }
+    if (name == "avx512") { return min_plus_update_avx512; }
+#endif
+    return min_plus_update_scalar;
+}
+
+
+/**
+ * @brief Widest kernel supported by this CPU, decided once via CPUID so the
+ *        same binary runs on every node.
+ */
+std::string detect_min_plus_kernel() {
+    const char* preference[] = {"avx512", "avx2", "sse4.1"};
+    for (const char* name : preference) {
+        if (min_plus_kernel_supported(name)) { return name; }
+    }
+    return "scalar";
+}
+
+
+static std::string min_plus_kernel_name = detect_min_plus_kernel();
+static min_plus_update_fn min_plus_kernel = min_plus_kernel_by_name(min_plus_kernel_name);
+
+
+/**
+ * @brief Override the runtime selected kernel (used by the unit tests).
+ *
+ * @return false if the CPU does not support the kernel, the selection is
+ *         left unchanged in that case.
+ */
+bool set_min_plus_kernel(std::string name) {
+    if (!min_plus_kernel_supported(name)) { return false; }
+    min_plus_kernel_name = name;
+    min_plus_kernel = min_plus_kernel_by_name(name);
+    return true;
+}
+
+
+/**
+ * @brief Min-plus update through the selected kernel, see min_plus_update_fn.
+ */
+inline void min_plus_update(
+        int* c, const int* a, const int* b, size_t stride, int rows, int cols, int depth) {
+    min_plus_kernel(c, a, b, stride, rows, cols, depth);
+}
+
+#endif
@@ -4,184 +4,390 @@
 #include "../core/core_utils.h"
 #include "Edge.h"
 #include "Matrix_2D.h"
+#include "barriers.h"
+#include "blocked_utils.h"
+#include "checkpoint_utils.h"
+#include "csr_graph.h"
+#include "engine_select.h"
+#include "matrix_output.h"
+#include "min_plus.h"
+#include "pruning_utils.h"
+#include "scc_utils.h"
+#include "sparse_utils.h"
+#include "task_scheduler.h"
+#include "thread_pool.h"
 #include <atomic>
-#include <condition_variable>
 #include <limits.h>
 #include <map>
+#include <memory>
 #include <mutex>
-#include <sstream>
 #include <thread>
 #include <vector>
 
 #define DEFAULT_NUMBER_OF_THREADS "1"
+#define DEFAULT_PARALLEL_ENGINE "copy"
 #define THREAD_LOGS 0
 // #define ADDITIONAL_TIMER_LOGS 0
 
 
-// taken from CMPT 431 Spring 2024 Assignment 3
-struct CustomBarrier {
-  int num_of_threads_;
-  int current_waiting_;
-  int barrier_call_;
-  std::mutex my_mutex_;
-  std::condition_variable my_cv_;
-
-  CustomBarrier(int t_num_of_threads)
-      : num_of_threads_(t_num_of_threads), current_waiting_(0),
-        barrier_call_(0) {}
-
-  void wait() {
-    std::unique_lock<std::mutex> u_lock(my_mutex_);
-    int c = barrier_call_;
-    current_waiting_++;
-    if (current_waiting_ == num_of_threads_) {
-      current_waiting_ = 0;
-      // unlock and send signal to wake up
-      barrier_call_++;
-      u_lock.unlock();
-      my_cv_.notify_all();
-      return;
-    }
-    my_cv_.wait(u_lock, [&] { return (c != barrier_call_); });
-    //  Condition has been reached. return
-  }
-};
-
-
 /**
- * @brief Given a csv line, seperate them such that the ith character is
- *        the output vertex and the i+1th character is the wieght of the edge. 
- * 
- * @param edges A map of input vertices with a key of edges.
- * @param input_vertex Input vertex for the directed edge.
- * @param csv_line String of output vertices and weights.
- */
-void generate_edges(
-        std::map<int, std::vector<Edge>>& edges, 
-        int input_vertex, 
-        std::string csv_line) {
-    
-    std::stringstream ss(csv_line);
-    std::vector<int> values;
-
-    int value;
-    // Read values from stringstream separated by commas
-    while (ss >> value) {
-        values.push_back(value);
-        if (ss.peek() == ',') {ss.ignore(); } // ignore the commas
-    }
-    
-    int mod = 0;
-    int weight;
-    int output_vertex;
-    while (!values.empty()) { // extract the edge weights and the output vertices
-        if (mod == 0) { // value is an output vertex
-            output_vertex = values.front();
-        } else { // value is a weight
-            weight = values.front();
-
-            // create an edge
-            edges[input_vertex].push_back(Edge(input_vertex, output_vertex, weight));
-        }
-        values.erase(values.begin());
-        mod = (mod + 1) % 2;
-    }
-}
-
-/**
- * @brief Function that will be used by a worker thread
+ * @brief Function that will be used by a worker thread. The pivots start at
+ *        first_pivot, after a resumed checkpoint, and every worker copies its
+ *        rows into the checkpoints that fall due (checkpoint may be NULL).
+ *        With prunable pivots (see prunable_pivots) those are skipped with
+ *        their barriers and copy, and only the rows reaching a pivot are
+ *        relaxed, counted in prune_stats. A pruned pivot changes no row, so
+ *        its checkpoint is still due and its rows match the last barrier; a
+ *        worker that runs ahead to the next due checkpoint waits in
+ *        snapshot_part until the pending one is complete.
 */
 void parallize(
         Matrix_2D* curr_distances, Matrix_2D* prev_distances,
-        CustomBarrier* barrier, double* time_taken, int* start_row, 
-        int* end_row, int thread_id, int* n_threads) {
+        Barrier* barrier, double* time_taken, double* barrier_time, int* start_row, 
+        int* end_row, int thread_id, int* n_threads,
+        int first_pivot = 0, CheckpointWriter* checkpoint = NULL,
+        const std::vector<bool>* prunable = NULL, PruneStats* prune_stats = NULL) {
     
     timer local_timer;
     local_timer.start();
+    *barrier_time = 0;
     int size = curr_distances->get_dimension();
+    bool pruning = prunable != NULL && !prunable->empty();
+    if (pruning) { prune_stats->pivots = size - first_pivot; }
 
     // compute the shortest paths
-        for (int k = 0; k < size; k++) {
-            for (int j = 0; j < size; j++) {
-                for (int i = *start_row; i < *end_row; i++) {
-                    try {
-                        int current_path_weight = curr_distances->get_matrix_value(i, j);
-                        int new_path_weight = prev_distances->get_matrix_value(i, k) 
-                                              + prev_distances->get_matrix_value(k, j);
-
-                        if (current_path_weight > new_path_weight) {
-                            curr_distances->set_matrix_value(i, j, new_path_weight);
-                        }
-                    } catch (const IndexOutOfBoundsException& e) {
-                        std::cout << "index was out of bounds!\n";
-                    }
+        for (int k = first_pivot; k < size; k++) {
+            if (pruning && (*prunable)[k]) {
+                prune_stats->pivots_skipped++;
+            } else {
+                if (pruning) {
+                    int first, last;
+                    pivot_row_span(prev_distances->row(k), k, size, first, last);
+                    relax_pivot_rows(
+                        curr_distances, prev_distances, NULL, *start_row, *end_row, k,
+                        first, last, prune_stats
+                    );
+                } else {
+                    min_plus_update(
+                        curr_distances->row(*start_row), prev_distances->row(*start_row) + k,
+                        prev_distances->row(k), curr_distances->get_stride(),
+                        *end_row - *start_row, size, 1
+                    );
                 }
+                timed_wait(barrier, thread_id, barrier_time);
+                if (thread_id == *n_threads - 1) {
+                    prev_distances->update_matrix(curr_distances);
+
+                }     
+                timed_wait(barrier, thread_id, barrier_time);
+            }
+            if (checkpoint != NULL && checkpoint->due(k + 1)) {
+                checkpoint->snapshot_part(curr_distances, NULL, *start_row, *end_row, k + 1);
             }
-            barrier->wait();       
-            if (thread_id == *n_threads - 1) {
-                prev_distances->update_matrix(curr_distances);
+        }
 
-            }     
-            barrier->wait();
+    *time_taken = local_timer.stop();
+}
+
+
+/**
+ * @brief Worker for the in place engine. Row k and column k do not change
+ *        while k is the pivot, so every thread can relax its rows directly in
+ *        the one distance matrix. The owner of row k skips it during pivot k
+ *        (it would only rewrite the same values), which leaves row k read-only
+ *        for the other threads, and a single barrier per k is enough. With
+ *        --paths the next hops are updated with the distances, they follow
+ *        the same rule. After the barrier of a pivot every worker copies its
+ *        rows into a due checkpoint and goes on, only its own rows are
+ *        written during the next pivot. Prunable pivots are skipped without
+ *        a barrier but still copy a due checkpoint, as in parallize.
+ */
+void parallize_in_place(
+        Matrix_2D* distances, NextHopMatrix* next_hops, Barrier* barrier,
+        double* time_taken, double* barrier_time, int* start_row, int* end_row, int thread_id,
+        int first_pivot = 0, CheckpointWriter* checkpoint = NULL,
+        const std::vector<bool>* prunable = NULL, PruneStats* prune_stats = NULL) {
+
+    timer local_timer;
+    local_timer.start();
+    *barrier_time = 0;
+    int size = distances->get_dimension();
+    int stride = distances->get_stride();
+    bool pruning = prunable != NULL && !prunable->empty();
+    if (pruning) { prune_stats->pivots = size - first_pivot; }
+
+    for (int k = first_pivot; k < size; k++) {
+        if (pruning && (*prunable)[k]) {
+            prune_stats->pivots_skipped++;
+            if (checkpoint != NULL && checkpoint->due(k + 1)) {
+                checkpoint->snapshot_part(distances, next_hops, *start_row, *end_row, k + 1);
+            }
+            continue;
+        }
+        const int* row_k = distances->row(k);
+        int pivot = std::min(std::max(k, *start_row), *end_row);
+        int first_after = (pivot == k) ? pivot + 1 : pivot;
+        if (pruning) {
+            int first, last;
+            pivot_row_span(row_k, k, size, first, last);
+            relax_pivot_rows(
+                distances, distances, next_hops, *start_row, *end_row, k, first, last, prune_stats
+            );
+        } else if (next_hops != NULL) {
+            update_block_paths(distances, next_hops, *start_row, pivot, 0, size, k, k + 1);
+            update_block_paths(distances, next_hops, first_after, *end_row, 0, size, k, k + 1);
+        } else {
+            int* first_row = distances->row(*start_row);
+            min_plus_update(
+                first_row, first_row + k, row_k, stride, pivot - *start_row, size, 1
+            );
+            if (pivot < *end_row) { // rows after the pivot row
+                int* rows_after = distances->row(first_after);
+                min_plus_update(
+                    rows_after, rows_after + k, row_k, stride, *end_row - first_after, size, 1
+                );
+            }
+        }
+        timed_wait(barrier, thread_id, barrier_time);
+        if (checkpoint != NULL && checkpoint->due(k + 1)) {
+            checkpoint->snapshot_part(distances, next_hops, *start_row, *end_row, k + 1);
         }
+    }
 
     *time_taken = local_timer.stop();
 }
 
 
-bool all_pairs_parallel(std::vector<std::string> csv_lines, int n_threads) {
-    
-    
-    std::map<int, std::vector<Edge>> edges;
-    for (int i = 0; i < csv_lines.size(); i++) {
-        edges[i];
-        generate_edges(edges, i, csv_lines[i]);
+/**
+ * @brief Update of one tile for one pivot block, a node of the blocked
+ *        Floyd-Warshall task graph.
+ */
+struct TileTask {
+    int round; // pivot block
+    int row;   // tile row
+    int col;   // tile column
+};
+
+
+/**
+ * @brief Number of tasks that must finish before tile (row, col) can be
+ *        updated with pivot block `round`. Besides the pivot tiles of the
+ *        same round, the pivot tiles of a round wait for their whole tile row
+ *        (column tiles) or tile column (row tiles) from the previous round,
+ *        which also guarantees nobody still reads a tile when it is
+ *        overwritten.
+ *
+ *        diagonal: row and column `round` of the previous round
+ *        pivot row/column: its tile column/row of the previous round + diagonal
+ *        remaining: itself in the previous round + its two pivot tiles
+ *
+ *        The first round of a run (first_round) depends on nothing before it.
+ */
+int tile_dependencies(int round, int row, int col, int n_tiles, int first_round = 0) {
+    bool first = round == first_round;
+    if (row == round && col == round) { return first ? 0 : 2 * n_tiles - 1; }
+    if (row == round || col == round) { return first ? 1 : n_tiles + 1; }
+    return first ? 2 : 3;
+}
+
+
+/**
+ * @brief Blocked Floyd-Warshall where every tile update is a task of a DAG
+ *        run by a work-stealing scheduler. A tile of round k+1 starts as soon
+ *        as the tiles it depends on are done instead of waiting at a global
+ *        barrier for the whole of round k.
+ *
+ *        Each tile keeps two pending dependency counters, one per round
+ *        parity. The counter of round k+2 is reset when the round k task of
+ *        the tile completes; every task that decrements it depends on that
+ *        completion, so a counter is never reset while it is still in use.
+ *
+ *        With checkpoints the rounds run as several DAGs, each ending at the
+ *        first tile boundary after a multiple of the checkpoint interval. The
+ *        matrix is consistent between two of them, the workers copy it into
+ *        the checkpoint and the writer thread saves it during the next DAG.
+ *        A resumed run starts at the round holding first_pivot: applying the
+ *        pivots of that round again can only find the same distances.
+ *
+ * @param distances Distance matrix, updated in place.
+ * @param tile_size Width and height of a tile.
+ * @param scheduler Scheduler running the tasks.
+ * @param pool Threads running the scheduler workers.
+ * @param next_hops Next hops updated with the distances, NULL without --paths.
+ * @param first_pivot Pivots already applied to the distances.
+ * @param checkpoint Writer of the checkpoints, NULL for none.
+ */
+void parallel_blocked_floyd_warshall(
+        Matrix_2D* distances, int tile_size, WorkStealingScheduler<TileTask>& scheduler,
+        ThreadPool& pool, NextHopMatrix* next_hops = NULL, int first_pivot = 0,
+        CheckpointWriter* checkpoint = NULL) {
+
+    int n = distances->get_dimension();
+    int n_tiles = (n + tile_size - 1) / tile_size;
+    if (n_tiles == 0) { return; }
+    int tiles = n_tiles * n_tiles;
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[2 * tiles]);
+    int first_round = first_pivot / tile_size;
+    int last_round = n_tiles;
+
+    auto notify = [&](int round, int row, int col, int worker_id) {
+        if (pending[(round % 2) * tiles + row * n_tiles + col].fetch_sub(1) == 1) {
+            scheduler.push(worker_id, TileTask{round, row, col});
+        }
+    };
+
+    auto execute = [&](TileTask task, int worker_id) {
+        int round = task.round;
+        int row = task.row;
+        int col = task.col;
+        update_tile(
+            distances,
+            row * tile_size, std::min((row + 1) * tile_size, n),
+            col * tile_size, std::min((col + 1) * tile_size, n),
+            round * tile_size, std::min((round + 1) * tile_size, n),
+            next_hops
+        );
+
+        if (round + 2 < last_round) {
+            pending[(round % 2) * tiles + row * n_tiles + col] =
+                tile_dependencies(round + 2, row, col, n_tiles, first_round);
+        }
+
+        // tiles of this round reading the tile as a pivot
+        for (int other = 0; other < n_tiles; other++) {
+            if (other == round) { continue; }
+            if (row == round && col == round) {
+                notify(round, round, other, worker_id);
+                notify(round, other, round, worker_id);
+            } else if (row == round) {
+                notify(round, other, col, worker_id);
+            } else if (col == round) {
+                notify(round, row, other, worker_id);
+            }
+        }
+
+        // next round: the tile itself, its pivot column tile and pivot row tile
+        int next = round + 1;
+        if (next < last_round) {
+            notify(next, row, col, worker_id);
+            if (col != next) { notify(next, row, next, worker_id); }
+            if (row != next) { notify(next, next, col, worker_id); }
+        }
+    };
+
+    for (; first_round < n_tiles; first_round = last_round) {
+        last_round = n_tiles;
+        if (checkpoint != NULL) {
+            int due_pivot = (first_round * tile_size / checkpoint->get_interval() + 1)
+                * checkpoint->get_interval();
+            last_round = std::min(n_tiles, (due_pivot + tile_size - 1) / tile_size);
+        }
+
+        for (int row = 0; row < n_tiles; row++) {
+            for (int col = 0; col < n_tiles; col++) {
+                for (int round = first_round; round < first_round + 2; round++) {
+                    pending[(round % 2) * tiles + row * n_tiles + col] =
+                        tile_dependencies(round, row, col, n_tiles, first_round);
+                }
+            }
+        }
+        scheduler.push(0, TileTask{first_round, first_round, first_round});
+        scheduler.run((long) (last_round - first_round) * tiles, execute, pool);
+
+        if (last_round < n_tiles) {
+            int n_workers = pool.get_n_threads();
+            pool.run([&](int i) {
+                checkpoint->snapshot_part(
+                    distances, next_hops, (int) ((long) n * i / n_workers),
+                    (int) ((long) n * (i + 1) / n_workers), last_round * tile_size
+                );
+            });
+        }
     }
-    
-    // initalize the distances
-    Matrix_2D* curr_distances = new Matrix_2D(csv_lines.size(), INFINITY_INT);
-    Matrix_2D* prev_distances = new Matrix_2D(csv_lines.size(), INFINITY_INT);
+}
+
 
-    if (curr_distances == NULL || prev_distances == NULL) {
-        std::cout << "Memory error!\n";
-        return false;
+/**
+ * @brief Initialize rows [start_row, end_row) of the distances: infinity,
+ *        0 on the diagonal and the edge weight (clamped to INFINITY_INT) for
+ *        every edge. Run by the worker that owns the rows, so it is the first
+ *        to touch their pages and they are allocated on its NUMA node.
+ */
+void initialize_rows(Matrix_2D* distances, CSRGraph& graph, int start_row, int end_row) {
+    distances->fill_rows(start_row, end_row, INFINITY_INT);
+    for (int vertex = start_row; vertex < end_row; vertex++) {
+        seed_distance_row(distances->row(vertex), graph, vertex, 0, graph.get_n_vertices());
     }
+}
 
-    // time the all-pairs shortest path computations
-    timer parallel_timer;
-    parallel_timer.start();
 
+/**
+ * @brief Check if the engine name is supported by all_pairs_parallel.
+ */
+bool is_parallel_engine(std::string engine) {
+    return engine == "copy" || engine == "inplace" || engine == "blocked"
+        || engine == "scc" || is_sssp_engine(engine);
+}
 
-    for (int vertex = 0; vertex < csv_lines.size(); vertex++) {
-        // self loops have a weight of 0
-        curr_distances->set_matrix_value(vertex,vertex, 0); // self loops have a weight of 0
-        prev_distances->set_matrix_value(vertex,vertex, 0); // self loops have a weight of 0
-        for (Edge edge: edges[vertex]) {
-            bool result;
-            if (edge.is_self_loop()) { // self loops have a weight of 0
-                result = curr_distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_input_vertex(), 0
-                );
-                result &= prev_distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_input_vertex(), 0
-                );
-            } else {
-                result = curr_distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_output_vertex(), edge.get_weight()
-                );
-                result &= prev_distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_output_vertex(), edge.get_weight()
-                );
-            }
-            if (!result) { return false; } // update failure
+
+/**
+ * @brief Check if the engine can keep the next hops of --paths, the copy
+ *        engine would need a second copy of them.
+ */
+bool engine_supports_paths(std::string engine) {
+    return engine == "inplace" || engine == "blocked" || engine == "scc"
+        || is_sssp_engine(engine);
+}
+
+
+/**
+ * @brief Load the newest checkpoint of the run into the seeded distances
+ *        (and next hops), every worker reading its own rows. A checkpoint
+ *        that can't be read leaves the seeded rows as they were.
+ *
+ * @return Pivots applied by the checkpoint, 0 if there is none.
+ */
+int resume_checkpoint(
+        const CheckpointOptions& options, const CheckpointHeader& header, CSRGraph& graph,
+        Matrix_2D* distances, Matrix_2D* prev_distances, NextHopMatrix* next_hops,
+        ThreadPool& pool, int* start_rows, int* end_rows) {
+    std::string file;
+    int pivot = latest_checkpoint(options.path, header, file);
+    if (pivot <= 0) { return 0; }
+
+    std::atomic<bool> loaded(true);
+    pool.run([&](int i) {
+        if (!read_checkpoint_rows(file, distances, next_hops, start_rows[i], end_rows[i])) {
+            loaded = false;
         }
+    });
+    if (!loaded) {
+        std::cout << "Unable to read checkpoint (" << file << "), starting at pivot 0" << std::endl;
+        pool.run([&](int i) {
+            initialize_rows(distances, graph, start_rows[i], end_rows[i]);
+            if (next_hops != NULL) { next_hops->seed_rows(distances, start_rows[i], end_rows[i]); }
+        });
+        return 0;
     }
+    if (prev_distances != NULL) { prev_distances->update_matrix(distances); }
+    return pivot;
+}
+
+
+bool all_pairs_parallel(
+        CSRGraph& graph, int n_threads, std::string engine, int tile_size,
+        std::string barrier_kind, std::vector<int> cpus,
+        std::string output_file, std::string output_format, bool paths,
+        CheckpointOptions checkpoint_options = CheckpointOptions()) {
+    
 
-    // create threads and ditribute the work across n_threads
-    int rows_per_thread = csv_lines.size() / n_threads;
-    int remainder = csv_lines.size() % n_threads;
+    // the same pinned workers initialize the matrix, run the engine and
+    // ditribute the rows across n_threads
+    ThreadPool pool(n_threads, cpus);
+    ThreadRunner run_on_pool = [&pool](std::function<void(int)> fn) { pool.run(fn); };
+    int rows_per_thread = graph.get_n_vertices() / n_threads;
+    int remainder = graph.get_n_vertices() % n_threads;
 
-    std::thread threads[n_threads];
     int start_rows[n_threads];
     int end_rows[n_threads];
     for (int i = 0; i < n_threads; i++) {
@@ -191,39 +397,224 @@ bool all_pairs_parallel(std::vector<std::string> csv_lines, int n_threads) {
             end_rows[i] += remainder;
         }
     }    
+    
+    // allocate the distances, the in place engines only need one matrix
+    bool in_place = engine == "inplace" || engine == "blocked" || engine == "scc"
+        || is_sssp_engine(engine);
+    Matrix_2D* curr_distances = new Matrix_2D(graph.get_n_vertices());
+    Matrix_2D* prev_distances = in_place ? NULL : new Matrix_2D(graph.get_n_vertices());
+    NextHopMatrix* next_hops = paths ? new NextHopMatrix(graph.get_n_vertices()) : NULL;
 
-    CustomBarrier* barrier = new CustomBarrier(n_threads);
-    double thread_time_taken[n_threads];
+    // time the all-pairs shortest path computations
+    timer parallel_timer;
+    parallel_timer.start();
 
-    for (int i = 0; i < n_threads; i++) {
-        threads[i] = std::thread(
-            parallize,
-            curr_distances, 
-            prev_distances, 
-            barrier,
-            &(thread_time_taken[i]),
-            &(start_rows[i]), 
-            &(end_rows[i]), 
-            i, 
-            &(n_threads)
+    if (is_sssp_engine(engine)) {
+        // one Dijkstra per source, the workers claim chunks of sources
+        std::vector<int64_t> potentials;
+        int n_buckets;
+        if (!prepare_dijkstra(graph, engine, potentials, n_buckets)) {
+            delete curr_distances;
+            delete next_hops;
+            return false;
+        }
+        std::atomic<int> next_source(0);
+        int sources[n_threads];
+        double thread_time_taken[n_threads];
+        pool.run([&](int i) {
+            timer local_timer;
+            local_timer.start();
+            sources[i] = dijkstra_rows(
+                graph, curr_distances, potentials, n_buckets, next_source, next_hops
+            );
+            thread_time_taken[i] = local_timer.stop();
+        });
+
+        double time_taken = parallel_timer.stop();
+        bool written = output_matrix(curr_distances, output_file, output_format, n_threads, run_on_pool);
+        if (paths) {
+            written &= output_next_hops(
+                next_hops, output_file, output_format, n_threads, run_on_pool
+            );
+        }
+        std::cout << "thread_id,\tsources,\t\ttime_taken,\tcpu\n";
+        std::string delim = ",\t\t";
+        for (int i = 0; i < n_threads; i++) {
+            std::cout << i << delim << sources[i] << delim << thread_time_taken[i]
+                      << delim << pool.get_cpu(i) << std::endl;
+        }
+        std::cout << "Total time taken: " << time_taken << std::endl;
+        delete curr_distances;
+        delete next_hops;
+        return written;
+    }
+
+    if (engine == "scc") {
+        // components on their own, the large ones on the blocked engine with
+        // every worker, then the rows between them over the condensation
+        SccDecomposition scc = decompose_graph(graph);
+        SccStats scc_stats(n_threads);
+        ComponentSolver solve_shared = [&](Matrix_2D* local, NextHopMatrix* local_hops) {
+            WorkStealingScheduler<TileTask> scheduler(n_threads);
+            parallel_blocked_floyd_warshall(local, tile_size, scheduler, pool, local_hops);
+        };
+        if (!scc_floyd_warshall(
+                graph, scc, curr_distances, next_hops, tile_size, n_threads, run_on_pool,
+                solve_shared, &scc_stats)) {
+            delete curr_distances;
+            delete next_hops;
+            return false;
+        }
+
+        double time_taken = parallel_timer.stop();
+        bool written = output_matrix(curr_distances, output_file, output_format, n_threads, run_on_pool);
+        if (paths) {
+            written &= output_next_hops(
+                next_hops, output_file, output_format, n_threads, run_on_pool
+            );
+        }
+        std::cout << "thread_id,\tcomponents,\trows,\t\ttime_taken,\tcpu\n";
+        std::string delim = ",\t\t";
+        for (int i = 0; i < n_threads; i++) {
+            std::cout << i << delim << scc_stats.components[i] << delim << scc_stats.rows[i]
+                      << delim << scc_stats.time_taken[i] << delim << pool.get_cpu(i) << std::endl;
+        }
+        std::cout << "Total time taken: " << time_taken << std::endl;
+        std::cout << describe_scc(scc) << std::endl;
+        delete curr_distances;
+        delete next_hops;
+        return written;
+    }
+
+    // every worker first-touches the rows it owns
+    pool.run([&](int i) {
+        initialize_rows(curr_distances, graph, start_rows[i], end_rows[i]);
+        if (!in_place) { initialize_rows(prev_distances, graph, start_rows[i], end_rows[i]); }
+        if (paths) { next_hops->seed_rows(curr_distances, start_rows[i], end_rows[i]); }
+    });
+
+    // pick up where the newest checkpoint of the graph left off and keep
+    // checkpointing; the files are removed once the result is written
+    int first_pivot = 0;
+    std::unique_ptr<CheckpointWriter> checkpoint;
+    if (checkpoint_options.enabled()) {
+        int n = graph.get_n_vertices();
+        CheckpointHeader header = checkpoint_header(
+            n, checkpoint_options.fingerprint, 0, n, 0, n, paths ? next_hops->get_width() : 0
+        );
+        if (checkpoint_options.resume) {
+            first_pivot = resume_checkpoint(
+                checkpoint_options, header, graph, curr_distances, prev_distances, next_hops,
+                pool, start_rows, end_rows
+            );
+        }
+        checkpoint.reset(new CheckpointWriter(
+            checkpoint_options.path, header, checkpoint_options.interval, n_threads
+        ));
+    }
+    auto report_checkpoints = [&](bool written) {
+        if (!checkpoint) { return; }
+        checkpoint->finish();
+        if (written) { checkpoint->remove_files(); }
+        std::cout << describe_checkpoints(*checkpoint, first_pivot) << std::endl;
+    };
+
+    if (engine == "blocked") {
+        WorkStealingScheduler<TileTask> scheduler(n_threads);
+        parallel_blocked_floyd_warshall(
+            curr_distances, tile_size, scheduler, pool, next_hops, first_pivot, checkpoint.get()
         );
+
+        double time_taken = parallel_timer.stop();
+        bool written = output_matrix(curr_distances, output_file, output_format, n_threads, run_on_pool);
+        if (paths) {
+            written &= output_next_hops(
+                next_hops, output_file, output_format, n_threads, run_on_pool
+            );
+        }
+        std::cout << "thread_id,\ttasks,\t\tsteals,\t\ttime_taken,\tcpu\n";
+        std::string delim = ",\t\t";
+        for (int i = 0; i < n_threads; i++) {
+            std::cout << i << delim << scheduler.get_executed(i) << delim
+                      << scheduler.get_stolen(i) << delim << scheduler.get_time_taken(i)
+                      << delim << pool.get_cpu(i) << std::endl;
+        }
+        std::cout << "Total time taken: " << time_taken << std::endl;
+        report_checkpoints(written);
+        delete curr_distances;
+        delete next_hops;
+        return written;
     }
 
-    for (int i = 0; i < n_threads; i++) { threads[i].join(); }
+    Barrier* barrier = make_barrier(barrier_kind, n_threads);
+    double thread_time_taken[n_threads];
+    double thread_barrier_time[n_threads];
+    std::vector<bool> prunable = prunable_pivots(graph);
+    std::vector<PruneStats> prune_stats(n_threads);
+
+    pool.run([&](int i) {
+        if (in_place) {
+            parallize_in_place(
+                curr_distances,
+                next_hops,
+                barrier,
+                &(thread_time_taken[i]),
+                &(thread_barrier_time[i]),
+                &(start_rows[i]),
+                &(end_rows[i]),
+                i,
+                first_pivot,
+                checkpoint.get(),
+                &prunable,
+                &(prune_stats[i])
+            );
+        } else {
+            parallize(
+                curr_distances, 
+                prev_distances, 
+                barrier,
+                &(thread_time_taken[i]),
+                &(thread_barrier_time[i]),
+                &(start_rows[i]), 
+                &(end_rows[i]), 
+                i, 
+                &(n_threads),
+                first_pivot,
+                checkpoint.get(),
+                &prunable,
+                &(prune_stats[i])
+            );
+        }
+    });
 
     double time_taken = parallel_timer.stop();
-    std::cout << "Final matrix\n";
-    curr_distances->print_matrix();
-    std::cout << "thread_id,\tstart_row,\tend_row,\ttime_taken\n";
+    bool written = output_matrix(curr_distances, output_file, output_format, n_threads, run_on_pool);
+    if (paths) {
+        written &= output_next_hops(next_hops, output_file, output_format, n_threads, run_on_pool);
+    }
+    std::cout << "thread_id,\tstart_row,\tend_row,\ttime_taken,\tbarrier_wait,\tcpu\n";
     std::string delim = ",\t\t";
     for (int i = 0; i < n_threads; i++) {
-        std::cout << i << delim << start_rows[i] << delim << end_rows[i] << delim << thread_time_taken[i] << std::endl;
+        std::cout << i << delim << start_rows[i] << delim << end_rows[i] << delim
+                  << thread_time_taken[i] << delim << thread_barrier_time[i]
+                  << delim << pool.get_cpu(i) << std::endl;
     }    
     std::cout << "Total time taken: " << time_taken << std::endl; 
+    // every thread skips the same pivots and relaxes its own rows
+    PruneStats pruned = prune_stats[0];
+    pruned.rows_relaxed = 0;
+    pruned.cells_relaxed = 0;
+    for (int i = 0; i < n_threads; i++) {
+        pruned.rows_relaxed += prune_stats[i].rows_relaxed;
+        pruned.cells_relaxed += prune_stats[i].cells_relaxed;
+    }
+    std::cout << describe_pruning(pruned, graph.get_n_vertices(), !prunable.empty()) << std::endl;
+    report_checkpoints(written);
     delete curr_distances;
     delete prev_distances;
+    delete next_hops;
     delete barrier;
-    return true;
+    return written;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+#ifndef PATH_UTILS_H
+#define PATH_UTILS_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief Bytes per next hop, the narrowest unsigned type holding every vertex
+ *        of an n vertex graph plus the all-bits-set "no path" value.
+ */
+int next_hop_width(int n) {
+    if (n <= UINT8_MAX) { return 1; }
+    if (n <= UINT16_MAX) { return 2; }
+    return 4;
+}
+
+
+/**
+ * @brief Successor matrix of the shortest paths: entry (i, j) is the vertex
+ *        after i on a shortest path from i to j, i itself when j == i and all
+ *        bits set when j is unreachable. Entries are 1, 2 or 4 bytes wide
+ *        (see next_hop_width) and rows are not padded.
+ *
+ *        The engines update it next to the distances, so a path is read back
+ *        in O(path length) with reconstruct_path instead of searching again.
+ */
+class NextHopMatrix {
+
+private:
+    int dimension;
+    int width;
+    char* hops;
+
+public:
+    /**
+     * @brief Allocate the matrix without touching its memory, the rows are
+     *        filled by seed_rows from the thread that will update them.
+     *
+     * @param dimension Number of vertices.
+     */
+    explicit NextHopMatrix(int dimension)
+        : dimension(dimension), width(next_hop_width(dimension)),
+          hops(new char[(size_t) dimension * dimension * width + 1]) {}
+
+    ~NextHopMatrix() { delete[] hops; }
+
+    NextHopMatrix(const NextHopMatrix&) = delete;
+    NextHopMatrix& operator=(const NextHopMatrix&) = delete;
+
+    int get_dimension() const { return dimension; }
+    int get_width() const { return width; }
+    const char* data() const { return hops; }
+
+    template <typename Hop>
+    inline Hop* row(int row) { return (Hop*) hops + (size_t) row * dimension; }
+
+    inline char* row_bytes(int row) { return hops + (size_t) row * dimension * width; }
+
+    /**
+     * @brief Call fn with the first row as a pointer of the hop type, so the
+     *        kernels are instantiated once per width and not switched per hop.
+     */
+    template <typename Fn>
+    void visit(Fn fn) {
+        if (width == 1) {
+            fn(row<uint8_t>(0));
+        } else if (width == 2) {
+            fn(row<uint16_t>(0));
+        } else {
+            fn(row<uint32_t>(0));
+        }
+    }
+
+    /**
+     * @return Vertex after from on a shortest path to to, -1 if there is none.
+     */
+    int next_hop(int from, int to) const {
+        size_t index = (size_t) from * dimension + to;
+        uint32_t hop;
+        if (width == 1) {
+            hop = ((const uint8_t*) hops)[index];
+            if (hop == UINT8_MAX) { return -1; }
+        } else if (width == 2) {
+            hop = ((const uint16_t*) hops)[index];
+            if (hop == UINT16_MAX) { return -1; }
+        } else {
+            hop = ((const uint32_t*) hops)[index];
+            if (hop == UINT32_MAX) { return -1; }
+        }
+        return (int) hop;
+    }
+
+    /**
+     * @brief Seed rows [start_row, end_row) from the seeded distances: the
+     *        next hop towards j is j itself for every edge and the diagonal.
+     */
+    void seed_rows(const Matrix_2D* distances, int start_row, int end_row) {
+        visit([&](auto* first_row) {
+            typedef typename std::remove_pointer<decltype(first_row)>::type Hop;
+            for (int i = start_row; i < end_row; i++) {
+                const int* values = distances->row(i);
+                Hop* next = first_row + (size_t) i * dimension;
+                for (int j = 0; j < dimension; j++) {
+                    next[j] = values[j] < INFINITY_INT ? (Hop) j : (Hop) ~(Hop) 0;
+                }
+            }
+        });
+    }
+};
+
+
+/**
+ * @brief Min-plus update of min_plus_update_fn that also records, for every
+ *        improved entry C[i][j], the next hop of A[i][k] (the first step of
+ *        the path through k). Only strict improvements move a next hop, so
+ *        row k and column k stay unchanged while k is the pivot.
+ */
+template <typename Hop>
+inline void min_plus_paths_update(
+        int* c, Hop* c_next, const int* a, const Hop* a_next, const int* b,
+        size_t stride, size_t next_stride, int rows, int cols, int depth) {
+
+    for (int k = 0; k < depth; k++) {
+        const int* b_row = b + k * stride;
+        for (int i = 0; i < rows; i++) {
+            int distance_ik = a[i * stride + k];
+            if (distance_ik >= INFINITY_INT) { continue; }
+            Hop hop_ik = a_next[i * next_stride + k];
+            int* c_row = c + i * stride;
+            Hop* next_row = c_next + i * next_stride;
+            for (int j = 0; j < cols; j++) {
+                int through_k = distance_ik + b_row[j];
+                if (through_k < c_row[j]) {
+                    c_row[j] = through_k;
+                    next_row[j] = hop_ik;
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Relax the block [row_start, row_end) x [col_start, col_end) through
+ *        the pivots [k_start, k_end), updating the distances and next hops
+ *        in place.
+ */
+void update_block_paths(
+        Matrix_2D* distances, NextHopMatrix* next_hops,
+        int row_start, int row_end, int col_start, int col_end, int k_start, int k_end) {
+
+    if (row_end <= row_start) { return; }
+    int n = next_hops->get_dimension();
+    int* block = distances->row(row_start);
+    next_hops->visit([&](auto* first_row) {
+        auto* next_block = first_row + (size_t) row_start * n;
+        min_plus_paths_update(
+            block + col_start, next_block + col_start, block + k_start, next_block + k_start,
+            distances->row(k_start) + col_start, distances->get_stride(), n,
+            row_end - row_start, col_end - col_start, k_end - k_start
+        );
+    });
+}
+
+
+/**
+ * @brief Vertices of a shortest path, read from the next hops in O(path
+ *        length).
+ *
+ * @return from, ..., to; empty if to is unreachable from from (or only
+ *         through a negative cycle).
+ */
+std::vector<int> reconstruct_path(const NextHopMatrix& next_hops, int from, int to) {
+    std::vector<int> path;
+    if (next_hops.next_hop(from, to) < 0) { return path; }
+    path.push_back(from);
+    // a negative cycle could make the hops loop, a simple path is at most n long
+    while (from != to && (int) path.size() <= next_hops.get_dimension()) {
+        from = next_hops.next_hop(from, to);
+        path.push_back(from);
+    }
+    if (from != to) { path.clear(); }
+    return path;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PRUNING_UTILS_H
+#define PRUNING_UTILS_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "csr_graph.h"
+#include "min_plus.h"
+#include "path_utils.h"
+#include <iomanip>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Work done by the pruned Floyd-Warshall loops of the naive, copy and
+ *        inplace engines.
+ */
+struct PruneStats {
+    int64_t pivots = 0;         // pivots run, fewer than n after --resume
+    int64_t pivots_skipped = 0; // pivots without in- or out-edges
+    int64_t rows_relaxed = 0;   // rows relaxed through a pivot
+    int64_t cells_relaxed = 0;  // entries those rows relaxed
+};
+
+
+/**
+ * @brief Pivots that cannot improve any distance: a vertex without out-edges
+ *        keeps an infinite row and one without in-edges an infinite column,
+ *        whatever the pivots before it found. The engines skip them, and
+ *        because the answer does not depend on the matrix, the threads
+ *        agree on it and skip the pivot's barrier as well. Self loops and
+ *        edges of weight INFINITY_INT or more are not counted.
+ *
+ *        Empty (no pruning) when a weight is negative: there infinity + w
+ *        can fall below infinity, and skipping those updates would change
+ *        the results.
+ */
+std::vector<bool> prunable_pivots(const CSRGraph& graph) {
+    int n = graph.get_n_vertices();
+    std::vector<bool> has_out(n, false);
+    std::vector<bool> has_in(n, false);
+    for (int u = 0; u < n; u++) {
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            int target = graph.get_target(e);
+            int weight = graph.get_weight(e);
+            if (target == u || weight >= INFINITY_INT) { continue; }
+            if (weight < 0) { return std::vector<bool>(); }
+            has_out[u] = true;
+            has_in[target] = true;
+        }
+    }
+    std::vector<bool> prunable(n);
+    for (int k = 0; k < n; k++) { prunable[k] = !has_out[k] || !has_in[k]; }
+    return prunable;
+}
+
+
+/**
+ * @brief Columns [first, last) of row k that can improve another row through
+ *        pivot k: from its first to its last finite entry, without the
+ *        diagonal. Only valid for non-negative weights.
+ */
+inline void pivot_row_span(const int* row_k, int k, int n, int& first, int& last) {
+    first = 0;
+    while (first < n && (first == k || row_k[first] >= INFINITY_INT)) { first++; }
+    last = n;
+    while (last > first && (last - 1 == k || row_k[last - 1] >= INFINITY_INT)) { last--; }
+}
+
+
+/**
+ * @brief Relax rows [start_row, end_row) of target through pivot k over the
+ *        columns [first, last) of its span. Column k and row k are read from
+ *        source (the target itself for the in place engines). Rows that do not
+ *        reach k are skipped, and so is row k, which k cannot improve with
+ *        non-negative weights.
+ *
+ * @param next_hops Next hops updated with the distances, NULL without --paths
+ *        (only with source == target).
+ */
+inline void relax_pivot_rows(
+        Matrix_2D* target, const Matrix_2D* source, NextHopMatrix* next_hops,
+        int start_row, int end_row, int k, int first, int last, PruneStats* stats) {
+    const int* row_k = source->row(k);
+    for (int i = start_row; i < end_row; i++) {
+        const int* row_i = source->row(i);
+        if (i == k || row_i[k] >= INFINITY_INT) { continue; }
+        if (next_hops != NULL) {
+            update_block_paths(target, next_hops, i, i + 1, first, last, k, k + 1);
+        } else {
+            min_plus_update(
+                target->row(i) + first, row_i + k, row_k + first, target->get_stride(),
+                1, last - first, 1
+            );
+        }
+        stats->rows_relaxed++;
+        stats->cells_relaxed += last - first;
+    }
+}
+
+
+/**
+ * @brief One line log of the pruning, e.g. "Pruning: skipped 12 of 100
+ *        pivots, 35.1% of row updates and 52.3% of entry updates".
+ */
+std::string describe_pruning(const PruneStats& stats, int n, bool enabled) {
+    if (!enabled) { return "Pruning: off, the graph has negative weights"; }
+    double rows = (double) stats.pivots * n;
+    double cells = rows * n;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "Pruning: skipped " << stats.pivots_skipped << " of " << stats.pivots << " pivots, "
+         << (rows > 0 ? 100 * (1 - stats.rows_relaxed / rows) : 0) << "% of row updates and "
+         << (cells > 0 ? 100 * (1 - stats.cells_relaxed / cells) : 0) << "% of entry updates";
+    return line.str();
+}
+
+#endif
@@ -0,0 +1,513 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include "../core/core_utils.h"
+#include "graph_parser.h"
+#include "matrix_format.h"
+#include "matrix_output.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define DEFAULT_SERVER_THREADS "4"
+#define DEFAULT_PROTOCOL "line"
+#define LATENCY_BUCKETS 512
+#define MAX_FRAME_VALUES (1 << 24)
+
+// binary protocol operations
+#define QUERY_DISTANCES 1 // count (u, v) pairs, one distance each
+#define QUERY_ROWS 2      // count vertices u, the whole row of each
+
+// binary protocol reply status
+#define QUERY_OK 0
+#define QUERY_BAD_VERTEX 1
+#define QUERY_BAD_OPERATION 2
+
+
+/**
+ * @brief Request frame of the binary protocol (little-endian), followed by
+ *        count int32 (u, v) pairs for QUERY_DISTANCES or count int32 vertices
+ *        for QUERY_ROWS.
+ */
+struct QueryFrame {
+    uint32_t operation;
+    uint32_t count;
+};
+
+
+/**
+ * @brief Reply frame of the binary protocol, followed by count int32
+ *        distances when status is QUERY_OK. Unreachable pairs hold the
+ *        infinity value of the matrix file.
+ */
+struct ReplyFrame {
+    int32_t status;
+    uint32_t count;
+};
+
+
+/**
+ * @brief Log-linear histogram of query latencies in nanoseconds: values
+ *        below 8 get their own bucket, above that every power of two is
+ *        split into 8 buckets, so a percentile is off by at most 12.5%.
+ *        Counters are atomic, so stats can be read while the owner records.
+ */
+class LatencyHistogram {
+
+private:
+    std::atomic<uint64_t> counts[LATENCY_BUCKETS];
+
+public:
+    LatencyHistogram() {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) { counts[b] = 0; }
+    }
+
+    static int bucket(uint64_t nanoseconds) {
+        if (nanoseconds < 8) { return (int) nanoseconds; }
+        int exponent = 63 - __builtin_clzll(nanoseconds);
+        return (exponent - 2) * 8 + (int) ((nanoseconds >> (exponent - 3)) & 7);
+    }
+
+    static uint64_t bucket_start(int bucket) {
+        if (bucket < 8) { return bucket; }
+        int exponent = bucket / 8 + 2;
+        return (uint64_t) (8 + bucket % 8) << (exponent - 3);
+    }
+
+    void record(uint64_t nanoseconds) {
+        counts[bucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t get_count(int bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+};
+
+
+/**
+ * @brief Latency below which a fraction of the recorded queries fall, the
+ *        end of the bucket holding that query.
+ *
+ * @param histograms Per thread histograms, merged.
+ * @param fraction e.g. 0.99 for p99.
+ * @param total Number of queries recorded.
+ */
+uint64_t latency_percentile(
+        const std::vector<std::unique_ptr<LatencyHistogram>>& histograms, double fraction,
+        uint64_t* total) {
+
+    std::vector<uint64_t> merged(LATENCY_BUCKETS, 0);
+    *total = 0;
+    for (const std::unique_ptr<LatencyHistogram>& histogram : histograms) {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) { merged[b] += histogram->get_count(b); }
+    }
+    for (int b = 0; b < LATENCY_BUCKETS; b++) { *total += merged[b]; }
+    if (*total == 0) { return 0; }
+
+    uint64_t rank = (uint64_t) (fraction * (*total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += merged[b];
+        if (seen >= rank) { return LatencyHistogram::bucket_start(b + 1); }
+    }
+    return LatencyHistogram::bucket_start(LATENCY_BUCKETS);
+}
+
+
+/**
+ * @brief Check if the protocol name is supported by apsp_serve.
+ */
+bool is_query_protocol(std::string protocol) {
+    return protocol == "line" || protocol == "binary";
+}
+
+
+/**
+ * @brief Answers distance queries from a mapped binary distance matrix.
+ *
+ *        Line protocol, one request and one reply per line:
+ *
+ *            d u v           distance from u to v, or INF
+ *            r u             the n distances of row u, space separated
+ *            b u v u v ...   distance of every pair, space separated
+ *            stats           queries answered so far and their p50 and p99
+ *                            latency in nanoseconds
+ *
+ *        A malformed request (an unknown command word, or anything left
+ *        after the arguments) is answered with "ERR <reason>". Binary
+ *        protocol: QueryFrame requests answered by ReplyFrame replies.
+ *
+ *        The matrix is read only, so any number of threads can answer
+ *        queries at the same time; thread_id picks the latency histogram.
+ */
+class QueryServer {
+
+private:
+    const MappedMatrix& matrix;
+    int rows;
+    int columns;
+    const int* distances;
+    std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+
+    bool valid_pair(int from, int to) const {
+        return from >= 0 && from < rows && to >= 0 && to < columns;
+    }
+
+    static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    /**
+     * @brief scan_int for a request argument, which must end at a blank or
+     *        the end of the line ("d 1 2x" is not "d 1 2").
+     */
+    static bool scan_argument(const char*& begin, const char* end, int& value) {
+        return scan_int(begin, end, value) && (begin == end || is_blank(*begin));
+    }
+
+    static bool only_blanks(const char* begin, const char* end) {
+        while (begin < end && is_blank(*begin)) { begin++; }
+        return begin == end;
+    }
+
+    static uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    }
+
+    void append_distance(std::string& reply, int distance) const {
+        if (distance >= matrix.header.infinity) {
+            reply += "INF";
+        } else {
+            char digits[12];
+            reply.append(digits, format_int(digits, distance) - digits);
+        }
+    }
+
+public:
+    /**
+     * @param matrix Mapped distance matrix, 4 byte elements.
+     * @param n_threads Number of threads answering queries.
+     */
+    QueryServer(const MappedMatrix& matrix, int n_threads)
+        : matrix(matrix), rows(matrix.header.rows), columns(matrix.header.columns),
+          distances((const int*) matrix.values) {
+        for (int t = 0; t < n_threads; t++) {
+            latencies.emplace_back(new LatencyHistogram());
+        }
+    }
+
+    int distance(int from, int to) const { return distances[(size_t) from * columns + to]; }
+
+    /**
+     * @brief "queries <n> p50_ns <latency> p99_ns <latency>"
+     */
+    std::string stats() const {
+        uint64_t total;
+        uint64_t p50 = latency_percentile(latencies, 0.5, &total);
+        uint64_t p99 = latency_percentile(latencies, 0.99, &total);
+        return "queries " + std::to_string(total) + " p50_ns " + std::to_string(p50)
+            + " p99_ns " + std::to_string(p99);
+    }
+
+    /**
+     * @brief Answer one request line of the line protocol.
+     *
+     * @param begin First character of the line, without its newline.
+     * @param end One past the last character of the line.
+     * @param reply Reply line appended to, newline included.
+     * @param thread_id Thread answering, records the latency.
+     */
+    void answer_line(const char* begin, const char* end, std::string& reply, int thread_id) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (begin < end && is_blank(*begin)) { begin++; }
+        if (begin == end) { return; } // empty lines get no reply
+        // the command is the whole first word, "statsx" is not "stats"
+        const char* word = begin;
+        while (begin < end && !is_blank(*begin)) { begin++; }
+        std::string command(word, begin);
+        size_t reply_start = reply.size();
+
+        int from, to;
+        if (command == "d") {
+            if (scan_argument(begin, end, from) && scan_argument(begin, end, to)
+                    && only_blanks(begin, end) && valid_pair(from, to)) {
+                append_distance(reply, distance(from, to));
+            } else {
+                reply += "ERR expected d <from> <to> with vertices in [0, "
+                    + std::to_string(rows) + ")";
+            }
+        } else if (command == "r") {
+            if (scan_argument(begin, end, from) && only_blanks(begin, end) && valid_pair(from, 0)) {
+                const int* row = distances + (size_t) from * columns;
+                reply.reserve(reply.size() + (size_t) columns * 12);
+                for (int j = 0; j < columns; j++) {
+                    if (j > 0) { reply += ' '; }
+                    append_distance(reply, row[j]);
+                }
+            } else {
+                reply += "ERR expected r <from> with a vertex in [0, " + std::to_string(rows) + ")";
+            }
+        } else if (command == "b") {
+            bool valid = true;
+            bool first = true;
+            while (valid && scan_argument(begin, end, from)) {
+                valid = scan_argument(begin, end, to) && valid_pair(from, to);
+                if (!valid) { break; }
+                if (!first) { reply += ' '; }
+                append_distance(reply, distance(from, to));
+                first = false;
+            }
+            if (!valid || !only_blanks(begin, end)) {
+                reply.resize(reply_start);
+                reply += "ERR expected b <from> <to> ... with vertices in [0, "
+                    + std::to_string(rows) + ")";
+            }
+        } else if (command == "stats" && only_blanks(begin, end)) {
+            reply += stats() + "\n";
+            return;
+        } else {
+            reply += "ERR unknown request";
+        }
+        reply += '\n';
+        latencies[thread_id]->record(elapsed_nanoseconds(start));
+    }
+
+    /**
+     * @brief Answer one request frame of the binary protocol.
+     *
+     * @param frame Request header.
+     * @param values count pairs or vertices following the header.
+     * @param reply Reply frame appended to.
+     * @param thread_id Thread answering, records the latency.
+     */
+    void answer_frame(
+            const QueryFrame& frame, const int32_t* values, std::string& reply, int thread_id) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ReplyFrame header = {QUERY_OK, 0};
+        size_t header_at = reply.size();
+        reply.append((const char*) &header, sizeof(header));
+
+        if (frame.operation == QUERY_DISTANCES) {
+            for (uint32_t q = 0; q < frame.count && header.status == QUERY_OK; q++) {
+                if (!valid_pair(values[2 * q], values[2 * q + 1])) {
+                    header.status = QUERY_BAD_VERTEX;
+                    break;
+                }
+                int32_t value = distance(values[2 * q], values[2 * q + 1]);
+                reply.append((const char*) &value, sizeof(value));
+            }
+            header.count = frame.count;
+        } else if (frame.operation == QUERY_ROWS) {
+            for (uint32_t q = 0; q < frame.count; q++) {
+                if (!valid_pair(values[q], 0)) {
+                    header.status = QUERY_BAD_VERTEX;
+                    break;
+                }
+                reply.append(
+                    (const char*) (distances + (size_t) values[q] * columns),
+                    (size_t) columns * sizeof(int32_t)
+                );
+            }
+            header.count = (uint32_t) std::min<uint64_t>((uint64_t) frame.count * columns, UINT32_MAX);
+        } else {
+            header.status = QUERY_BAD_OPERATION;
+        }
+        if (header.status != QUERY_OK) {
+            header.count = 0;
+            reply.resize(header_at + sizeof(header));
+        }
+        std::memcpy(&reply[header_at], &header, sizeof(header));
+        latencies[thread_id]->record(elapsed_nanoseconds(start));
+    }
+
+    /**
+     * @brief Answer every complete request at the front of a buffer.
+     *
+     * @param binary Binary protocol, the line protocol otherwise.
+     * @param data Bytes received.
+     * @param size Number of bytes received.
+     * @param reply Replies appended to.
+     * @param thread_id Thread answering.
+     * @return Bytes consumed, or -1 if a frame is too large to answer.
+     */
+    long answer_buffer(
+            bool binary, const char* data, size_t size, std::string& reply, int thread_id) {
+        size_t consumed = 0;
+        while (consumed < size) {
+            if (!binary) {
+                const char* newline = (const char*) std::memchr(
+                    data + consumed, '\n', size - consumed
+                );
+                if (newline == NULL) { break; }
+                answer_line(data + consumed, newline, reply, thread_id);
+                consumed = newline - data + 1;
+                continue;
+            }
+            if (size - consumed < sizeof(QueryFrame)) { break; }
+            QueryFrame frame;
+            std::memcpy(&frame, data + consumed, sizeof(frame));
+            uint64_t n_values = frame.operation == QUERY_DISTANCES
+                ? 2 * (uint64_t) frame.count
+                : frame.operation == QUERY_ROWS ? frame.count : 0;
+            if (n_values > MAX_FRAME_VALUES) { return -1; }
+            size_t frame_bytes = sizeof(frame) + n_values * sizeof(int32_t);
+            if (size - consumed < frame_bytes) { break; }
+            std::vector<int32_t> values(n_values);
+            std::memcpy(values.data(), data + consumed + sizeof(frame), n_values * sizeof(int32_t));
+            answer_frame(frame, values.data(), reply, thread_id);
+            consumed += frame_bytes;
+        }
+        return consumed;
+    }
+
+    /**
+     * @brief Answer the requests of one stream until it is closed. Every
+     *        read answers all the complete requests it holds with a single
+     *        write, so pipelined requests are batched.
+     *
+     * @return false if the stream could not be read or written.
+     */
+    bool serve_stream(int in_fd, int out_fd, bool binary, int thread_id) {
+        std::vector<char> buffer(1 << 16);
+        size_t filled = 0;
+        std::string reply;
+        while (true) {
+            if (filled == buffer.size()) { buffer.resize(2 * buffer.size()); }
+#ifdef _WIN32
+            int received = _read(in_fd, buffer.data() + filled, (unsigned int) (buffer.size() - filled));
+#else
+            ssize_t received = read(in_fd, buffer.data() + filled, buffer.size() - filled);
+#endif
+            if (received < 0 && errno == EINTR) { continue; }
+            if (received < 0) { return false; }
+            if (received == 0) { // a last line without its newline is still answered
+                reply.clear();
+                if (!binary && filled > 0) {
+                    answer_line(buffer.data(), buffer.data() + filled, reply, thread_id);
+                }
+                return write_all(out_fd, reply.data(), reply.size());
+            }
+            filled += received;
+
+            reply.clear();
+            long consumed = answer_buffer(binary, buffer.data(), filled, reply, thread_id);
+            if (consumed < 0) { return false; }
+            if (!write_all(out_fd, reply.data(), reply.size())) { return false; }
+            std::memmove(buffer.data(), buffer.data() + consumed, filled - consumed);
+            filled -= consumed;
+        }
+    }
+};
+
+
+#ifndef _WIN32
+
+static volatile sig_atomic_t stop_serving = 0;
+
+void request_stop(int) { stop_serving = 1; }
+
+
+/**
+ * @brief Serve queries on a Unix domain socket until SIGINT or SIGTERM. The
+ *        calling thread accepts the connections and hands them to n_threads
+ *        reader threads, each serving one connection at a time.
+ *
+ * @return false if the socket could not be created.
+ */
+bool serve_socket(QueryServer& server, std::string path, int n_threads, bool binary) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) { return false; }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) { return false; }
+    unlink(path.c_str());
+    if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        close(listener);
+        return false;
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN); // a client leaving early only ends its connection
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<int> pending;
+    std::set<int> active;
+    bool stopping = false;
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < n_threads; t++) {
+        readers.emplace_back([&, t]() {
+            while (true) {
+                int connection;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [&] { return stopping || !pending.empty(); });
+                    if (pending.empty()) { return; }
+                    connection = pending.front();
+                    pending.pop_front();
+                    active.insert(connection);
+                }
+                server.serve_stream(connection, connection, binary, t);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    active.erase(connection);
+                }
+                close(connection);
+            }
+        });
+    }
+
+    pollfd waiting = {listener, POLLIN, 0};
+    while (!stop_serving) {
+        if (poll(&waiting, 1, 100) <= 0) { continue; }
+        int connection = accept(listener, NULL, NULL);
+        if (connection < 0) { continue; }
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(connection);
+        ready.notify_one();
+    }
+
+    // stop reading from open connections, replies in flight are still sent
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (int connection : active) { shutdown(connection, SHUT_RD); }
+        for (int connection : pending) { close(connection); }
+        pending.clear();
+        ready.notify_all();
+    }
+    for (std::thread& reader : readers) { reader.join(); }
+    close(listener);
+    unlink(path.c_str());
+    return true;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,468 @@
+#ifndef SCC_UTILS_H
+#define SCC_UTILS_H
+
+#include "../core/core_utils.h"
+#include "../core/get_time.h"
+#include "Matrix_2D.h"
+#include "blocked_utils.h"
+#include "csr_graph.h"
+#include "matrix_format.h"
+#include "min_plus.h"
+#include "path_utils.h"
+#include "sparse_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// components of at least this many vertices are solved by every thread
+// together (see ComponentSolver), smaller ones by one thread each
+#ifndef SCC_SHARED_SIZE
+#define SCC_SHARED_SIZE 512
+#endif
+
+
+/**
+ * @brief Solves the all-pairs shortest paths of one large component in
+ *        place: its seeded distances and next hops (NULL without --paths),
+ *        indexed by the position of the vertices in the component.
+ */
+typedef std::function<void(Matrix_2D*, NextHopMatrix*)> ComponentSolver;
+
+
+/**
+ * @brief Edge from a vertex of a component to a vertex of another one, the
+ *        target is an index into the targets of the component.
+ */
+struct CrossEdge {
+    int from;
+    int target;
+    int weight;
+};
+
+
+/**
+ * @brief Strongly connected components of a graph and its condensation.
+ *        Components are numbered in the order Tarjan's algorithm closes them,
+ *        so an edge between two components always goes to the lower number.
+ *        The level of a component is 0 for a sink of the condensation and one
+ *        more than the highest level it has an edge to otherwise: the rows of
+ *        a level only read rows of lower levels.
+ */
+struct SccDecomposition {
+    int n_components = 0;
+    int n_levels = 0;
+    std::vector<int> component;      // component of every vertex
+    std::vector<int> position;       // index of every vertex in its component
+    std::vector<int> offsets;        // component c is members[offsets[c], offsets[c + 1])
+    std::vector<int> members;
+    std::vector<int> level;          // level of every component
+    std::vector<int> level_offsets;  // level l is level_vertices[level_offsets[l], level_offsets[l + 1])
+    std::vector<int> level_vertices;
+    std::vector<int> target_offsets; // distinct targets of the edges leaving component c
+    std::vector<int> targets;
+    std::vector<int> cross_offsets;  // edges leaving component c
+    std::vector<CrossEdge> cross_edges;
+
+    int size(int c) const { return offsets[c + 1] - offsets[c]; }
+};
+
+
+/**
+ * @brief Edges the decomposition follows: self loops and edges of weight
+ *        INFINITY_INT or more are not paths.
+ */
+inline bool scc_edge(const CSRGraph& graph, int u, int64_t edge) {
+    return graph.get_target(edge) != u && graph.get_weight(edge) < INFINITY_INT;
+}
+
+
+/**
+ * @brief Tarjan's algorithm with an explicit stack of (vertex, next edge)
+ *        frames, the recursion would overflow on long paths.
+ *
+ * @param component Component of every vertex, sinks of the condensation
+ *        first.
+ * @return Number of components.
+ */
+int strongly_connected_components(const CSRGraph& graph, std::vector<int>& component) {
+    int n = graph.get_n_vertices();
+    component.assign(n, -1);
+    std::vector<int> index(n, -1);
+    std::vector<int> low(n);
+    std::vector<int> stack;
+    std::vector<std::pair<int, int64_t>> frames;
+    int next_index = 0;
+    int n_components = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (index[root] >= 0) { continue; }
+        index[root] = low[root] = next_index++;
+        stack.push_back(root);
+        frames.push_back(std::make_pair(root, graph.edges_begin(root)));
+        while (!frames.empty()) {
+            int v = frames.back().first;
+            int64_t edge = frames.back().second;
+            if (edge < graph.edges_end(v)) {
+                frames.back().second++;
+                if (!scc_edge(graph, v, edge)) { continue; }
+                int w = graph.get_target(edge);
+                if (index[w] < 0) {
+                    index[w] = low[w] = next_index++;
+                    stack.push_back(w);
+                    frames.push_back(std::make_pair(w, graph.edges_begin(w)));
+                } else if (component[w] < 0) {
+                    low[v] = std::min(low[v], index[w]); // w is still on the stack
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    component[w] = n_components;
+                } while (w != v);
+                n_components++;
+            }
+            if (!frames.empty()) {
+                int parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+    return n_components;
+}
+
+
+/**
+ * @brief Components, levels and the edges between components of a graph.
+ */
+SccDecomposition decompose_graph(const CSRGraph& graph) {
+    SccDecomposition scc;
+    int n = graph.get_n_vertices();
+    scc.n_components = strongly_connected_components(graph, scc.component);
+    int n_components = scc.n_components;
+
+    // group the vertices by component
+    scc.offsets.assign(n_components + 1, 0);
+    for (int v = 0; v < n; v++) { scc.offsets[scc.component[v] + 1]++; }
+    for (int c = 0; c < n_components; c++) { scc.offsets[c + 1] += scc.offsets[c]; }
+    scc.members.resize(n);
+    scc.position.resize(n);
+    std::vector<int> filled(scc.offsets.begin(), scc.offsets.end() - 1);
+    for (int v = 0; v < n; v++) {
+        int c = scc.component[v];
+        scc.position[v] = filled[c] - scc.offsets[c];
+        scc.members[filled[c]++] = v;
+    }
+
+    // edges leaving every component and the levels, the components an edge
+    // goes to are numbered lower and already done
+    scc.level.assign(n_components, 0);
+    scc.target_offsets.assign(1, 0);
+    scc.cross_offsets.assign(1, 0);
+    std::vector<int> slot(n, -1);
+    for (int c = 0; c < n_components; c++) {
+        int first_target = scc.targets.size();
+        for (int i = scc.offsets[c]; i < scc.offsets[c + 1]; i++) {
+            int u = scc.members[i];
+            for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+                int v = graph.get_target(e);
+                if (!scc_edge(graph, u, e) || scc.component[v] == c) { continue; }
+                if (slot[v] < 0) {
+                    slot[v] = scc.targets.size() - first_target;
+                    scc.targets.push_back(v);
+                }
+                scc.cross_edges.push_back({u, slot[v], graph.get_weight(e)});
+                scc.level[c] = std::max(scc.level[c], scc.level[scc.component[v]] + 1);
+            }
+        }
+        for (size_t t = first_target; t < scc.targets.size(); t++) { slot[scc.targets[t]] = -1; }
+        scc.target_offsets.push_back(scc.targets.size());
+        scc.cross_offsets.push_back(scc.cross_edges.size());
+        scc.n_levels = std::max(scc.n_levels, scc.level[c] + 1);
+    }
+
+    // group the vertices by level
+    scc.level_offsets.assign(scc.n_levels + 1, 0);
+    for (int c = 0; c < n_components; c++) { scc.level_offsets[scc.level[c] + 1] += scc.size(c); }
+    for (int l = 0; l < scc.n_levels; l++) { scc.level_offsets[l + 1] += scc.level_offsets[l]; }
+    scc.level_vertices.resize(n);
+    filled.assign(scc.level_offsets.begin(), scc.level_offsets.end() - 1);
+    for (int c = 0; c < n_components; c++) {
+        for (int i = scc.offsets[c]; i < scc.offsets[c + 1]; i++) {
+            scc.level_vertices[filled[scc.level[c]]++] = scc.members[i];
+        }
+    }
+    return scc;
+}
+
+
+/**
+ * @brief Work of the scc engine, per thread.
+ */
+struct SccStats {
+    std::vector<int> components;     // components solved alone
+    std::vector<int> rows;           // rows composed from lower levels
+    std::vector<double> time_taken;
+
+    explicit SccStats(int n_threads)
+        : components(n_threads, 0), rows(n_threads, 0), time_taken(n_threads, 0) {}
+};
+
+
+/**
+ * @brief Solve component c and write its rows: the distances and next hops
+ *        inside the component, infinity everywhere else.
+ *
+ * @return false if the component has a negative cycle.
+ */
+bool solve_component(
+        const CSRGraph& graph, const SccDecomposition& scc, int c, Matrix_2D* distances,
+        NextHopMatrix* next_hops, ComponentSolver solver) {
+    int n = graph.get_n_vertices();
+    int size = scc.size(c);
+    const int* vertices = &scc.members[scc.offsets[c]];
+
+    Matrix_2D local(size, INFINITY_INT);
+    if (size > 1) {
+        for (int i = 0; i < size; i++) {
+            int u = vertices[i];
+            int* row = local.row(i);
+            for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+                int v = graph.get_target(e);
+                if (scc_edge(graph, u, e) && scc.component[v] == c) {
+                    row[scc.position[v]] = graph.get_weight(e);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < size; i++) { local.row(i)[i] = 0; } // self loops have a weight of 0
+
+    std::unique_ptr<NextHopMatrix> local_hops;
+    if (next_hops != NULL) {
+        local_hops.reset(new NextHopMatrix(size));
+        local_hops->seed_rows(&local, 0, size);
+    }
+    if (size > 1) { solver(&local, local_hops.get()); }
+    for (int i = 0; i < size; i++) {
+        if (local.row(i)[i] < 0) { return false; }
+    }
+
+    for (int i = 0; i < size; i++) {
+        int* row = distances->row(vertices[i]);
+        std::fill(row, row + n, INFINITY_INT);
+        const int* local_row = local.row(i);
+        for (int j = 0; j < size; j++) { row[vertices[j]] = local_row[j]; }
+    }
+    if (next_hops != NULL) {
+        next_hops->visit([&](auto* first_row) {
+            typedef typename std::remove_pointer<decltype(first_row)>::type Hop;
+            for (int i = 0; i < size; i++) {
+                Hop* next = first_row + (size_t) vertices[i] * n;
+                std::fill(next, next + n, (Hop) ~(Hop) 0);
+                for (int j = 0; j < size; j++) {
+                    int hop = local_hops->next_hop(i, j);
+                    if (hop >= 0) { next[vertices[j]] = (Hop) vertices[hop]; }
+                }
+            }
+        });
+    }
+    return true;
+}
+
+
+/**
+ * @brief Compose the row of u from the rows of the lower levels: a path
+ *        leaving the component of u does so through one of its cross edges
+ *        (x, y), so d[u][v] = min(d[u][x] + w(x, y) + d[y][v]). The cross
+ *        edges are first folded into one distance per target y, then row u
+ *        is relaxed once through every reachable y. Columns of the component
+ *        itself do not change, no other component reaches it.
+ *
+ * @param via Scratch of at least the number of targets of the component.
+ * @param via_hops Next hop towards each target, with next_hops.
+ * @param checked Skip infinite entries of the target rows, needed with
+ *        negative weights (infinity + w < infinity) and next hops.
+ */
+template <typename Hop>
+void compose_row(
+        const SccDecomposition& scc, int u, Matrix_2D* distances, Hop* first_hop_row,
+        std::vector<int>& via, std::vector<int>& via_hops, bool checked) {
+    int n = distances->get_columns();
+    int c = scc.component[u];
+    int n_targets = scc.target_offsets[c + 1] - scc.target_offsets[c];
+    const int* targets = &scc.targets[scc.target_offsets[c]];
+    int* row_u = distances->row(u);
+    Hop* hops_u = first_hop_row != NULL ? first_hop_row + (size_t) u * n : NULL;
+
+    std::fill(via.begin(), via.begin() + n_targets, INFINITY_INT);
+    for (int e = scc.cross_offsets[c]; e < scc.cross_offsets[c + 1]; e++) {
+        const CrossEdge& edge = scc.cross_edges[e];
+        int distance = row_u[edge.from];
+        if (distance >= INFINITY_INT) { continue; }
+        int through = distance + edge.weight;
+        if (through < via[edge.target]) {
+            via[edge.target] = through;
+            if (hops_u != NULL) {
+                via_hops[edge.target] = edge.from == u ? targets[edge.target] : hops_u[edge.from];
+            }
+        }
+    }
+
+    for (int t = 0; t < n_targets; t++) {
+        if (via[t] >= INFINITY_INT) { continue; }
+        const int* row_y = distances->row(targets[t]);
+        if (!checked) {
+            min_plus_update(row_u, &via[t], row_y, distances->get_stride(), 1, n, 1);
+            continue;
+        }
+        for (int j = 0; j < n; j++) {
+            if (row_y[j] >= INFINITY_INT) { continue; }
+            int through = via[t] + row_y[j];
+            if (through < row_u[j]) {
+                row_u[j] = through;
+                if (hops_u != NULL) { hops_u[j] = (Hop) via_hops[t]; }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief All-pairs shortest paths through the strongly connected components:
+ *        every component is solved on its own, the small ones by one thread
+ *        each with blocked Floyd-Warshall and the large ones (SCC_SHARED_SIZE
+ *        vertices or more) by solve_shared, then the rows leaving a component
+ *        are composed level by level over the condensation. The cubic work is
+ *        the sum of the component cubes, plus one row relaxation per row and
+ *        reachable target component vertex.
+ *
+ *        Every row is written, the distances need not be seeded. Vertices
+ *        that reach each other share a component, so the distances are exact
+ *        with negative weights too: an unreachable pair stays at infinity.
+ *
+ * @param next_hops Next hops, NULL without --paths.
+ * @param run Runs a function on the n_threads threads.
+ * @return false if the graph has a negative cycle.
+ */
+bool scc_floyd_warshall(
+        const CSRGraph& graph, const SccDecomposition& scc, Matrix_2D* distances,
+        NextHopMatrix* next_hops, int tile_size, int n_threads, ThreadRunner run,
+        ComponentSolver solve_shared, SccStats* stats) {
+    // large components first, one at a time on every thread
+    std::vector<int> small;
+    bool no_cycle = true;
+    for (int c = 0; c < scc.n_components; c++) {
+        if (scc.size(c) < SCC_SHARED_SIZE) {
+            small.push_back(c);
+        } else {
+            timer shared_timer;
+            shared_timer.start();
+            no_cycle &= solve_component(graph, scc, c, distances, next_hops, solve_shared);
+            stats->time_taken[0] += shared_timer.stop();
+        }
+    }
+
+    // small components largest first, so the last ones claimed are short
+    std::stable_sort(small.begin(), small.end(), [&scc](int a, int b) {
+        return scc.size(a) > scc.size(b);
+    });
+    ComponentSolver solve_alone = [tile_size](Matrix_2D* local, NextHopMatrix* local_hops) {
+        blocked_floyd_warshall(local, tile_size, local_hops);
+    };
+    std::atomic<int> next_component(0);
+    std::atomic<bool> no_small_cycle(true);
+    run([&](int i) {
+        timer local_timer;
+        local_timer.start();
+        int claimed;
+        while ((claimed = next_component.fetch_add(1)) < (int) small.size()) {
+            if (!solve_component(graph, scc, small[claimed], distances, next_hops, solve_alone)) {
+                no_small_cycle = false;
+            }
+            stats->components[i]++;
+        }
+        stats->time_taken[i] += local_timer.stop();
+    });
+    if (!no_cycle || !no_small_cycle) {
+        std::cout << "Negative cycle, shortest paths are undefined" << std::endl;
+        return false;
+    }
+
+    // compose the rows level by level, a level with few rows is not worth
+    // waking the threads for
+    int max_targets = 0;
+    for (int c = 0; c < scc.n_components; c++) {
+        max_targets = std::max(max_targets, scc.target_offsets[c + 1] - scc.target_offsets[c]);
+    }
+    bool checked = next_hops != NULL || has_negative_weights(graph);
+    std::vector<std::vector<int>> via(n_threads, std::vector<int>(max_targets));
+    std::vector<std::vector<int>> via_hops(n_threads, std::vector<int>(next_hops != NULL ? max_targets : 0));
+    auto compose = [&](auto* first_hop_row) {
+        for (int l = 1; l < scc.n_levels; l++) {
+            int first = scc.level_offsets[l];
+            int last = scc.level_offsets[l + 1];
+            std::atomic<int> next_row(first);
+            auto compose_level = [&](int i) {
+                timer local_timer;
+                local_timer.start();
+                int start;
+                while ((start = next_row.fetch_add(SOURCE_CHUNK)) < last) {
+                    int end = std::min(start + SOURCE_CHUNK, last);
+                    for (int r = start; r < end; r++) {
+                        compose_row(
+                            scc, scc.level_vertices[r], distances, first_hop_row,
+                            via[i], via_hops[i], checked
+                        );
+                    }
+                    stats->rows[i] += end - start;
+                }
+                stats->time_taken[i] += local_timer.stop();
+            };
+            if (last - first <= SOURCE_CHUNK) {
+                compose_level(0);
+            } else {
+                run(compose_level);
+            }
+        }
+    };
+    if (next_hops == NULL) {
+        compose((uint8_t*) NULL);
+    } else {
+        next_hops->visit(compose);
+    }
+    return true;
+}
+
+
+/**
+ * @brief One line log of the decomposition, e.g. "SCC: 412 components,
+ *        largest 1530 of 2000 vertices, 7 levels, 45.1% of the n^3 work".
+ */
+std::string describe_scc(const SccDecomposition& scc) {
+    double n = scc.component.size();
+    double work = 0;
+    int largest = 0;
+    for (int c = 0; c < scc.n_components; c++) {
+        double size = scc.size(c);
+        work += size * size * size;
+        largest = std::max(largest, scc.size(c));
+    }
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "SCC: " << scc.n_components << " components, largest " << largest << " of "
+         << scc.component.size() << " vertices, " << scc.n_levels << " levels, "
+         << (n > 0 ? 100 * work / (n * n * n) : 0) << "% of the n^3 work";
+    return line.str();
+}
+
+#endif
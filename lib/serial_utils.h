@@ -1,62 +1,76 @@
 #include "../core/core_utils.h"
 #include "Edge.h"
 #include "Matrix_2D.h"
+#include "blocked_utils.h"
+#include "csr_graph.h"
+#include "engine_select.h"
+#include "matrix_output.h"
+#include "min_plus.h"
+#include "path_utils.h"
+#include "pruning_utils.h"
+#include "scc_utils.h"
+#include "sparse_utils.h"
 #include <map>
 #include <vector>
-#include <sstream>
+
+#define DEFAULT_ENGINE "naive"
 
 /**
- * @brief Given a csv line, seperate them such that the ith character is
- *        the output vertex and the i+1th character is the wieght of the edge. 
- * 
- * @param edges A map of input vertices with a key of edges.
- * @param input_vertex Input vertex for the directed edge.
- * @param csv_line String of output vertices and weights.
+ * @brief Textbook Floyd-Warshall, one full sweep of the matrix per pivot.
+ *        When pruning, the prunable pivots are skipped, and only the rows
+ *        reaching a pivot are relaxed, over the finite span of its row (see
+ *        relax_pivot_rows).
+ *
+ * @param distances Distance matrix, updated in place.
+ * @param next_hops Next hops updated with the distances, NULL without --paths.
+ * @param prunable Pivots to skip (see prunable_pivots), NULL or empty to
+ *        sweep every pivot.
+ * @param stats Pruning counters, needed with prunable.
  */
-void generate_edges(
-        std::map<int, std::vector<Edge>>& edges, 
-        int input_vertex, 
-        std::string csv_line
-    ) {
-    
-    std::stringstream ss(csv_line);
-    std::vector<int> values;
-
-    int value;
-    // Read values from stringstream separated by commas
-    while (ss >> value) {
-        values.push_back(value);
-        if (ss.peek() == ',') {ss.ignore(); } // ignore the commas
-    }
-    
-    int mod = 0;
-    int weight;
-    int output_vertex;
-    while (!values.empty()) { // extract the edge weights and the output vertices
-        if (mod == 0) { // value is an output vertex
-            output_vertex = values.front();
-        } else { // value is a weight
-            weight = values.front();
-
-            // create an edge
-            edges[input_vertex].push_back(Edge(input_vertex, output_vertex, weight));
+void floyd_warshall(
+        Matrix_2D* distances, NextHopMatrix* next_hops = NULL,
+        const std::vector<bool>* prunable = NULL, PruneStats* stats = NULL) {
+    int n = distances->get_dimension();
+    if (prunable != NULL && !prunable->empty()) {
+        stats->pivots = n;
+        for (int k = 0; k < n; k++) {
+            if ((*prunable)[k]) {
+                stats->pivots_skipped++;
+                continue;
+            }
+            int first, last;
+            pivot_row_span(distances->row(k), k, n, first, last);
+            relax_pivot_rows(distances, distances, next_hops, 0, n, k, first, last, stats);
         }
-        values.erase(values.begin());
-        mod = (mod + 1) % 2;
+        return;
+    }
+    if (next_hops != NULL) {
+        update_block_paths(distances, next_hops, 0, n, 0, n, 0, n);
+        return;
+    }
+    int* first_row = distances->row(0);
+    for (int k = 0; k < n; k++) {
+        min_plus_update(
+            first_row, first_row + k, distances->row(k), distances->get_stride(), n, n, 1
+        );
     }
 }
 
 
-bool all_pairs_serial(std::vector<std::string> csv_lines) {
-    
-    std::map<int, std::vector<Edge>> edges;
-    for (int i = 0; i < csv_lines.size(); i++) {
-        edges[i];
-        generate_edges(edges, i, csv_lines[i]);
-    }
+/**
+ * @brief Check if the engine name is supported by all_pairs_serial.
+ */
+bool is_serial_engine(std::string engine) {
+    return engine == "naive" || engine == "blocked" || engine == "scc" || is_sssp_engine(engine);
+}
+
+
+bool all_pairs_serial(
+        CSRGraph& graph, std::string engine, int tile_size,
+        std::string output_file, std::string output_format, bool paths) {
     
     // initalize the distances
-    Matrix_2D* distances = new Matrix_2D(csv_lines.size(), INFINITY_INT);
+    Matrix_2D* distances = new Matrix_2D(graph.get_n_vertices(), INFINITY_INT);
     
     if (distances == NULL) {
         std::cout << "Memory error!\n";
@@ -66,46 +80,69 @@ bool all_pairs_serial(std::vector<std::string> csv_lines) {
     timer serial_timer;
     serial_timer.start();
 
-    for (int vertex = 0; vertex < csv_lines.size(); vertex++) {
-        distances->set_matrix_value(vertex,vertex, 0); // self loops have a weight of 0
-        for (Edge edge: edges[vertex]) {
-            bool result;
-            if (edge.is_self_loop()) { // self loops have a weight of 0
-                result = distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_input_vertex(), 0
-                );
-            } else {
-                 result = distances->set_matrix_value(
-                    edge.get_input_vertex(), edge.get_output_vertex(), edge.get_weight()
-                 );
-            }
-            if (!result) { return false; } // update failure
+    NextHopMatrix* next_hops = paths ? new NextHopMatrix(graph.get_n_vertices()) : NULL;
+    // the sssp and scc engines write whole rows themselves
+    bool dense = !is_sssp_engine(engine) && engine != "scc";
+    if (dense) {
+        for (int vertex = 0; vertex < graph.get_n_vertices(); vertex++) {
+            seed_distance_row(distances->row(vertex), graph, vertex, 0, graph.get_n_vertices());
         }
+        if (paths) { next_hops->seed_rows(distances, 0, graph.get_n_vertices()); }
     }
 
     // compute the shortest paths
-    for (int k = 0; k < csv_lines.size(); k++) {
-        for (int j = 0; j < csv_lines.size(); j++) {
-            for (int i = 0; i < csv_lines.size(); i++) {
-                try {
-                    int current_path_weight = distances->get_matrix_value(i, j);
-                    int new_path_weight = distances->get_matrix_value(i, k) 
-                                        + distances->get_matrix_value(k, j);
-
-                    if (current_path_weight > new_path_weight) {
-                        distances->set_matrix_value(i, j, new_path_weight);
-                    }
-                } catch (const IndexOutOfBoundsException& e) {
-                    return false;
-                }
-            }
+    PruneStats prune_stats;
+    std::vector<bool> prunable;
+    std::string scc_line;
+    if (is_sssp_engine(engine)) {
+        std::vector<int64_t> potentials;
+        int n_buckets;
+        if (!prepare_dijkstra(graph, engine, potentials, n_buckets)) {
+            delete distances;
+            delete next_hops;
+            return false;
+        }
+        std::atomic<int> next_source(0);
+        dijkstra_rows(graph, distances, potentials, n_buckets, next_source, next_hops);
+    } else if (engine == "blocked") {
+        blocked_floyd_warshall(distances, tile_size, next_hops);
+    } else if (engine == "scc") {
+        SccDecomposition scc = decompose_graph(graph);
+        SccStats scc_stats(1);
+        ComponentSolver solve = [tile_size](Matrix_2D* local, NextHopMatrix* local_hops) {
+            blocked_floyd_warshall(local, tile_size, local_hops);
+        };
+        ThreadRunner run_here = [](std::function<void(int)> fn) { fn(0); };
+        if (!scc_floyd_warshall(
+                graph, scc, distances, next_hops, tile_size, 1, run_here, solve, &scc_stats)) {
+            delete distances;
+            delete next_hops;
+            return false;
         }
+        scc_line = describe_scc(scc);
+    } else {
+        prunable = prunable_pivots(graph);
+        floyd_warshall(distances, next_hops, &prunable, &prune_stats);
     }
 
     double time_taken = serial_timer.stop();
-    std::cout << "Final matrix\n";
-    distances->print_matrix();    
+    bool written = output_matrix(
+        distances, output_file, output_format, ingest_threads(),
+        short_lived_threads(ingest_threads())
+    );
+    if (next_hops != NULL) {
+        written &= output_next_hops(
+            next_hops, output_file, output_format, ingest_threads(),
+            short_lived_threads(ingest_threads())
+        );
+    }
     std::cout << "Time taken: " << time_taken << std::endl; 
+    if (engine == "naive") {
+        std::cout << describe_pruning(prune_stats, graph.get_n_vertices(), !prunable.empty())
+                  << std::endl;
+    }
+    if (!scc_line.empty()) { std::cout << scc_line << std::endl; }
     delete distances;
-    return true;
+    delete next_hops;
+    return written;
 }
\ No newline at end of file
@@ -0,0 +1,377 @@
+#ifndef SPARSE_UTILS_H
+#define SPARSE_UTILS_H
+
+#include "../core/core_utils.h"
+#include "Matrix_2D.h"
+#include "csr_graph.h"
+#include "path_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// sources a worker claims at a time, small enough to balance uneven sources
+#define SOURCE_CHUNK 16
+
+// largest edge weight the bucket queue of the dial engine takes, above it
+// the buckets are mostly empty and the binary heap is used instead
+#define DIAL_MAX_WEIGHT 4096
+
+
+/**
+ * @brief Check if the engine runs one single source search per row.
+ */
+bool is_sssp_engine(std::string engine) {
+    return engine == "dijkstra" || engine == "dial";
+}
+
+
+/**
+ * @brief Check if a graph has a negative edge weight, which rules out a plain
+ *        Dijkstra and calls for the Johnson reweighting. Self loops do not
+ *        count, the engines give them a weight of 0.
+ */
+bool has_negative_weights(const CSRGraph& graph) {
+    for (int u = 0; u < graph.get_n_vertices(); u++) {
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            if (graph.get_weight(e) < 0 && graph.get_target(e) != u) { return true; }
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief Johnson potentials: Bellman-Ford (queue based) from a virtual source
+ *        with a 0 weight edge to every vertex. Reweighting every edge (u, v)
+ *        to w + h[u] - h[v] makes it non-negative without changing which
+ *        paths are shortest.
+ *
+ * @param graph Graph with negative weights.
+ * @param potentials h, one per vertex.
+ * @return false if the graph has a negative cycle.
+ */
+bool johnson_potentials(const CSRGraph& graph, std::vector<int64_t>& potentials) {
+    int n = graph.get_n_vertices();
+    potentials.assign(n, 0);
+    std::vector<int> queue(n);
+    std::vector<char> queued(n, 1);
+    std::vector<int> enqueues(n, 1);
+    for (int v = 0; v < n; v++) { queue[v] = v; }
+
+    // circular queue, every vertex is in it at most once. The queue runs in
+    // passes and a vertex is enqueued at most once per pass, and without a
+    // negative cycle every distance is final after n passes (a shortest path
+    // from the virtual source has at most n edges). A vertex can be relaxed
+    // many times in one pass, once per in-edge, so those are not counted.
+    size_t head = 0;
+    size_t size = n;
+    while (size > 0) {
+        int u = queue[head];
+        head = (head + 1) % n;
+        size--;
+        queued[u] = 0;
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            int v = graph.get_target(e);
+            if (graph.get_weight(e) >= INFINITY_INT || v == u) { continue; }
+            int64_t through = potentials[u] + graph.get_weight(e);
+            if (through >= potentials[v]) { continue; }
+            potentials[v] = through;
+            if (!queued[v]) {
+                if (++enqueues[v] > n) { return false; }
+                queue[(head + size) % n] = v;
+                size++;
+                queued[v] = 1;
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Heap entries ordered by distance, then vertex. A non-negative int
+ *        distance is packed with its vertex into one 64-bit key, which is
+ *        cheaper to compare and move than a pair; the int64_t reweighted
+ *        distances of the Johnson potentials keep a pair.
+ */
+inline uint64_t heap_entry(int distance, int vertex) {
+    return (uint64_t) distance << 32 | (uint32_t) vertex;
+}
+inline std::pair<int64_t, int> heap_entry(int64_t distance, int vertex) {
+    return std::make_pair(distance, vertex);
+}
+inline int entry_distance(uint64_t entry) { return (int) (entry >> 32); }
+inline int64_t entry_distance(const std::pair<int64_t, int>& entry) { return entry.first; }
+inline int entry_vertex(uint64_t entry) { return (int) (uint32_t) entry; }
+inline int entry_vertex(const std::pair<int64_t, int>& entry) { return entry.second; }
+
+
+/**
+ * @brief Dijkstra from one source with a binary heap and lazy deletion.
+ *
+ * @param graph Graph, self loops and edges of weight INFINITY_INT or more
+ *        are ignored.
+ * @param source Source vertex.
+ * @param distances n entries, filled with the distance to every vertex.
+ *        Unreachable vertices get INFINITY_INT as an int and the largest
+ *        value as an int64_t (the reweighted distances of the potentials).
+ * @param potentials Johnson potentials, NULL for non-negative weights.
+ * @param heap Buffer reused between sources.
+ * @param hops n entries receiving the next hop from the source towards
+ *        every vertex, NULL without --paths.
+ */
+template <typename Distance, typename Entry, typename Hop>
+void dijkstra(
+        const CSRGraph& graph, int source, Distance* distances, const int64_t* potentials,
+        std::vector<Entry>& heap, Hop* hops) {
+
+    int n = graph.get_n_vertices();
+    Distance unreached = sizeof(Distance) == sizeof(int)
+        ? (Distance) INFINITY_INT : std::numeric_limits<Distance>::max();
+    std::fill(distances, distances + n, unreached);
+    if (hops != NULL) { std::fill(hops, hops + n, (Hop) ~(Hop) 0); }
+    const int* targets = graph.get_targets();
+    const int* weights = graph.get_weights();
+    std::greater<Entry> later;
+
+    distances[source] = 0;
+    if (hops != NULL) { hops[source] = (Hop) source; }
+    heap.clear();
+    heap.push_back(heap_entry((Distance) 0, source));
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Distance distance = entry_distance(heap.back());
+        int u = entry_vertex(heap.back());
+        heap.pop_back();
+        if (distance > distances[u]) { continue; } // stale entry
+
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            int v = targets[e];
+            if (weights[e] >= INFINITY_INT || v == u) { continue; }
+            Distance weight = weights[e];
+            if (potentials != NULL) { weight += potentials[u] - potentials[v]; }
+            Distance through = distance + weight;
+            if (through >= distances[v]) { continue; }
+            distances[v] = through;
+            if (hops != NULL) { hops[v] = u == source ? (Hop) v : hops[u]; }
+            heap.push_back(heap_entry(through, v));
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+}
+
+
+/**
+ * @brief Dijkstra with Dial's bucket queue for small integer weights: bucket
+ *        d % n_buckets holds the vertices reached at distance d, and with
+ *        n_buckets above the largest weight every pending distance has its own
+ *        bucket. Extracting the minimum is a scan to the next non empty bucket
+ *        instead of a heap operation. Entries are not removed on an
+ *        improvement, stale ones are skipped when their bucket is drained.
+ *
+ * @param buckets n_buckets buckets, empty, left empty for the next source.
+ * @see dijkstra for the other parameters.
+ */
+template <typename Distance, typename Hop>
+void dial(
+        const CSRGraph& graph, int source, Distance* distances, const int64_t* potentials,
+        std::vector<std::vector<int>>& buckets, Hop* hops) {
+
+    int n = graph.get_n_vertices();
+    Distance unreached = sizeof(Distance) == sizeof(int)
+        ? (Distance) INFINITY_INT : std::numeric_limits<Distance>::max();
+    std::fill(distances, distances + n, unreached);
+    if (hops != NULL) { std::fill(hops, hops + n, (Hop) ~(Hop) 0); }
+    const int* targets = graph.get_targets();
+    const int* weights = graph.get_weights();
+    size_t n_buckets = buckets.size();
+
+    distances[source] = 0;
+    if (hops != NULL) { hops[source] = (Hop) source; }
+    buckets[0].push_back(source);
+    int64_t pending = 1;
+    for (Distance distance = 0; pending > 0; distance++) {
+        // 0 weight edges push into the bucket being drained
+        std::vector<int>& bucket = buckets[distance % n_buckets];
+        while (!bucket.empty()) {
+            int u = bucket.back();
+            bucket.pop_back();
+            pending--;
+            if (distances[u] != distance) { continue; } // stale entry
+
+            for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+                int v = targets[e];
+                if (weights[e] >= INFINITY_INT || v == u) { continue; }
+                Distance weight = weights[e];
+                if (potentials != NULL) { weight += potentials[u] - potentials[v]; }
+                Distance through = distance + weight;
+                if (through >= distances[v]) { continue; }
+                distances[v] = through;
+                if (hops != NULL) { hops[v] = u == source ? (Hop) v : hops[u]; }
+                buckets[through % n_buckets].push_back(v);
+                pending++;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Number of buckets the dial engine needs, the largest edge weight
+ *        (reweighted by the potentials) plus one.
+ *
+ * @return 0 if a weight is above DIAL_MAX_WEIGHT, the binary heap is used.
+ */
+int dial_bucket_count(const CSRGraph& graph, const std::vector<int64_t>& potentials) {
+    int64_t max_weight = 0;
+    for (int u = 0; u < graph.get_n_vertices(); u++) {
+        for (int64_t e = graph.edges_begin(u); e < graph.edges_end(u); e++) {
+            int v = graph.get_target(e);
+            if (graph.get_weight(e) >= INFINITY_INT || v == u) { continue; }
+            int64_t weight = graph.get_weight(e);
+            if (!potentials.empty()) { weight += potentials[u] - potentials[v]; }
+            max_weight = std::max(max_weight, weight);
+        }
+    }
+    return max_weight > DIAL_MAX_WEIGHT ? 0 : (int) max_weight + 1;
+}
+
+
+/**
+ * @brief Buffers of one thread's single source searches, reused between
+ *        sources.
+ */
+struct SsspScratch {
+    std::vector<uint64_t> heap;
+    std::vector<std::pair<int64_t, int>> wide_heap;
+    std::vector<int64_t> reweighted;
+    std::vector<std::vector<int>> buckets; // dial queue, empty for the heap
+
+    SsspScratch(int n_vertices, bool reweight, int n_buckets)
+        : reweighted(reweight ? n_vertices : 0), buckets(n_buckets) {}
+};
+
+
+/**
+ * @brief Compute the row of one source with dial or the binary heap. With
+ *        negative weights the Johnson potentials are used and the reweighted
+ *        distances are converted back, clamped to INFINITY_INT.
+ *
+ * @param row n entries receiving the distances from source.
+ * @param potentials Johnson potentials, empty for non-negative weights.
+ * @param scratch Buffers of the calling thread, the dial queue is used if it
+ *        has buckets.
+ * @param hops Next hops of the row, NULL without --paths.
+ */
+template <typename Hop>
+void sssp_row(
+        const CSRGraph& graph, int source, int* row, const std::vector<int64_t>& potentials,
+        SsspScratch& scratch, Hop* hops) {
+
+    int n = graph.get_n_vertices();
+    bool buckets = !scratch.buckets.empty();
+    if (potentials.empty()) {
+        if (buckets) {
+            dial(graph, source, row, (const int64_t*) NULL, scratch.buckets, hops);
+        } else {
+            dijkstra(graph, source, row, (const int64_t*) NULL, scratch.heap, hops);
+        }
+        return;
+    }
+
+    int64_t* reweighted = scratch.reweighted.data();
+    if (buckets) {
+        dial(graph, source, reweighted, potentials.data(), scratch.buckets, hops);
+    } else {
+        dijkstra(graph, source, reweighted, potentials.data(), scratch.wide_heap, hops);
+    }
+    for (int v = 0; v < n; v++) {
+        row[v] = reweighted[v] == std::numeric_limits<int64_t>::max()
+            ? INFINITY_INT
+            : (int) std::min<int64_t>(
+                reweighted[v] - potentials[source] + potentials[v], INFINITY_INT
+            );
+    }
+}
+
+
+/**
+ * @brief Compute the rows of the sources handed out by next_source with one
+ *        single source search each (see sssp_row), written straight into
+ *        their rows of the distances.
+ *
+ * @param graph Graph of the distances.
+ * @param distances Output matrix, every row is overwritten.
+ * @param potentials Johnson potentials, empty for non-negative weights.
+ * @param n_buckets Buckets of the dial queue, 0 for the binary heap.
+ * @param next_source Shared counter of the next unclaimed source.
+ * @param next_hops Next hops of --paths, NULL without it.
+ * @return Number of sources computed by the caller.
+ */
+int dijkstra_rows(
+        const CSRGraph& graph, Matrix_2D* distances, const std::vector<int64_t>& potentials,
+        int n_buckets, std::atomic<int>& next_source, NextHopMatrix* next_hops) {
+
+    int n = graph.get_n_vertices();
+    int computed = 0;
+    SsspScratch scratch(n, !potentials.empty(), n_buckets);
+
+    auto run = [&](auto* first_hops) {
+        typedef typename std::remove_pointer<decltype(first_hops)>::type Hop;
+        while (true) {
+            int start = next_source.fetch_add(SOURCE_CHUNK);
+            if (start >= n) { return; }
+            int end = std::min(start + SOURCE_CHUNK, n);
+            for (int source = start; source < end; source++) {
+                Hop* hops = first_hops == NULL ? NULL : first_hops + (size_t) source * n;
+                sssp_row(graph, source, distances->row(source), potentials, scratch, hops);
+                computed++;
+            }
+        }
+    };
+    if (next_hops == NULL) {
+        run((uint8_t*) NULL);
+    } else {
+        next_hops->visit(run);
+    }
+    return computed;
+}
+
+
+/**
+ * @brief Johnson potentials of the graph if it has negative weights, and the
+ *        buckets of the dial engine.
+ *
+ * @param engine dijkstra or dial.
+ * @param potentials Left empty for non-negative weights.
+ * @param n_buckets Buckets of the dial queue, 0 for the binary heap of the
+ *        dijkstra engine or when the weights are too large for the buckets.
+ * @return false if the graph has a negative cycle.
+ */
+bool prepare_dijkstra(
+        const CSRGraph& graph, std::string engine,
+        std::vector<int64_t>& potentials, int& n_buckets) {
+    potentials.clear();
+    n_buckets = 0;
+    if (has_negative_weights(graph) && !johnson_potentials(graph, potentials)) {
+        std::cout << "Negative cycle, shortest paths are undefined" << std::endl;
+        return false;
+    }
+    if (engine == "dial") {
+        n_buckets = dial_bucket_count(graph, potentials);
+        if (n_buckets == 0) {
+            std::cout << "Edge weights above " << DIAL_MAX_WEIGHT
+                      << ", using a binary heap" << std::endl;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "../core/get_time.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Work-stealing scheduler for a task DAG. Every worker owns a deque:
+ *        it pushes and pops newly ready tasks at the back (LIFO, the tiles it
+ *        just produced are still in cache) while idle workers steal from the
+ *        front of other deques (FIFO, the oldest and usually largest work).
+ *
+ *        Dependency tracking is left to the caller: a task is pushed once it
+ *        is ready and run() returns after total_tasks tasks were executed.
+ */
+template <typename Task>
+class WorkStealingScheduler {
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        long executed = 0;
+        long stolen = 0;
+        double time_taken = 0;
+    };
+
+    int n_workers;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<long> remaining;
+
+    bool pop(int worker_id, Task& task) {
+        Worker& worker = *workers[worker_id];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) { return false; }
+        task = worker.tasks.back();
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int thief_id, Task& task) {
+        for (int offset = 1; offset < n_workers; offset++) {
+            Worker& victim = *workers[(thief_id + offset) % n_workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Execute>
+    void work(int worker_id, Execute& execute) {
+        timer local_timer;
+        local_timer.start();
+        Worker& worker = *workers[worker_id];
+
+        Task task;
+        while (remaining.load() > 0) {
+            if (pop(worker_id, task)) {
+                execute(task, worker_id);
+            } else if (steal(worker_id, task)) {
+                worker.stolen++;
+                execute(task, worker_id);
+            } else {
+                std::this_thread::yield();
+                continue;
+            }
+            worker.executed++;
+            remaining--;
+        }
+        worker.time_taken += local_timer.stop();
+    }
+
+public:
+    WorkStealingScheduler(int n_workers) : n_workers(n_workers), remaining(0) {
+        for (int i = 0; i < n_workers; i++) {
+            workers.emplace_back(new Worker());
+        }
+    }
+
+    /**
+     * @brief Make a ready task available, called before run() for the roots
+     *        of the DAG and from execute() for tasks it unblocked.
+     *
+     * @param worker_id Worker whose deque receives the task.
+     * @param task Task ready to execute.
+     */
+    void push(int worker_id, Task task) {
+        Worker& worker = *workers[worker_id];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(task);
+    }
+
+    /**
+     * @brief Execute tasks on the pool until total_tasks have run. The pool
+     *        must have n_workers threads.
+     *
+     * @param total_tasks Number of tasks in the DAG.
+     * @param execute Callable as execute(Task, worker_id).
+     * @param pool Threads running the workers.
+     */
+    template <typename Execute>
+    void run(long total_tasks, Execute execute, ThreadPool& pool) {
+        remaining = total_tasks;
+        pool.run([this, &execute](int worker_id) { work(worker_id, execute); });
+    }
+
+    int get_n_workers() { return n_workers; }
+    long get_executed(int worker_id) { return workers[worker_id]->executed; }
+    long get_stolen(int worker_id) { return workers[worker_id]->stolen; }
+    double get_time_taken(int worker_id) { return workers[worker_id]->time_taken; }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <errno.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits.h>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define DEFAULT_AFFINITY "none"
+
+
+/**
+ * @brief Read an integer from a sysfs topology file, -1 if it is missing.
+ */
+int read_cpu_topology(int cpu, std::string file) {
+    std::ifstream input("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + file);
+    int value = -1;
+    if (!(input >> value)) { return -1; }
+    return value;
+}
+
+
+/**
+ * @brief CPUs this process is allowed to run on.
+ */
+std::vector<int> available_cpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+        }
+    }
+#endif
+    return cpus;
+}
+
+
+bool is_affinity_kind(std::string affinity) {
+    return affinity == "none" || affinity == "compact"
+        || affinity == "scatter" || affinity == "list";
+}
+
+
+/**
+ * @brief Parse the comma separated CPU ids of --cpuList, empty entries are
+ *        skipped.
+ *
+ * @return false if an entry is not a non-negative integer.
+ */
+bool parse_cpu_list(std::string cpu_list, std::vector<int>& cpus) {
+    cpus.clear();
+    std::stringstream ss(cpu_list);
+    std::string cpu;
+    while (std::getline(ss, cpu, ',')) {
+        if (cpu.empty()) { continue; }
+        char* end;
+        errno = 0;
+        long id = std::strtol(cpu.c_str(), &end, 10);
+        if (*end != '\0' || errno == ERANGE || id < 0 || id > INT_MAX) { return false; }
+        cpus.push_back((int) id);
+    }
+    return true;
+}
+
+
+/**
+ * @brief CPU for every thread of the pool, an empty vector means the
+ *        threads are not pinned.
+ *
+ * @param affinity none, compact (fill one socket, core by core, before the
+ *        next), scatter (round robin over the sockets) or list (cpu_list).
+ * @param cpu_list Comma separated CPU ids used by the list affinity, thread
+ *        i runs on the (i mod size)th entry. Checked with parse_cpu_list.
+ * @param n_threads Number of threads in the pool.
+ */
+std::vector<int> affinity_cpus(std::string affinity, std::string cpu_list, int n_threads) {
+    std::vector<int> order;
+    if (affinity == "list") {
+        parse_cpu_list(cpu_list, order);
+    } else if (affinity == "compact" || affinity == "scatter") {
+        std::vector<int> cpus = available_cpus();
+        std::sort(cpus.begin(), cpus.end(), [](int a, int b) {
+            int socket_a = read_cpu_topology(a, "physical_package_id");
+            int socket_b = read_cpu_topology(b, "physical_package_id");
+            if (socket_a != socket_b) { return socket_a < socket_b; }
+            int core_a = read_cpu_topology(a, "core_id");
+            int core_b = read_cpu_topology(b, "core_id");
+            if (core_a != core_b) { return core_a < core_b; }
+            return a < b;
+        });
+        if (affinity == "compact") {
+            order = cpus;
+        } else { // take one CPU from every socket in turn
+            std::map<int, std::vector<int>> sockets;
+            for (int cpu : cpus) { sockets[read_cpu_topology(cpu, "physical_package_id")].push_back(cpu); }
+            for (size_t index = 0; order.size() < cpus.size(); index++) {
+                for (auto& socket : sockets) {
+                    if (index < socket.second.size()) { order.push_back(socket.second[index]); }
+                }
+            }
+        }
+    }
+
+    std::vector<int> pinning;
+    for (int i = 0; i < n_threads && !order.empty(); i++) {
+        pinning.push_back(order[i % order.size()]);
+    }
+    return pinning;
+}
+
+
+/**
+ * @brief Fixed set of worker threads created once and reused for every
+ *        parallel phase (initialization, Floyd-Warshall, output), each one
+ *        optionally pinned to a CPU. Because a worker always runs on the same
+ *        core, the memory it touches first stays on its NUMA node.
+ */
+class ThreadPool {
+
+private:
+    int n_threads;
+    std::vector<int> cpus;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    std::function<void(int)> job;
+    long generation;
+    int running;
+    bool stopping;
+
+    void pin(int thread_id) {
+        if (cpus.empty()) { return; }
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[thread_id], &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            std::cerr << "Unable to pin thread " << thread_id << " to cpu " << cpus[thread_id] << std::endl;
+            cpus[thread_id] = -1; // reported as not pinned
+        }
+#endif
+    }
+
+    void worker(int thread_id) {
+        pin(thread_id);
+        long seen = 0;
+        while (true) {
+            std::function<void(int)> current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_cv.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) { return; }
+                seen = generation;
+                current = job;
+            }
+            current(thread_id);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            done_cv.notify_all();
+        }
+    }
+
+public:
+    ThreadPool(int n_threads, std::vector<int> cpus = std::vector<int>())
+        : n_threads(n_threads), cpus(cpus), generation(0), running(0), stopping(false) {
+        for (int i = 0; i < n_threads; i++) {
+            threads.emplace_back(&ThreadPool::worker, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (std::thread& thread : threads) { thread.join(); }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Run fn(thread_id) once on every worker and wait for all of them.
+     */
+    void run(std::function<void(int)> fn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        job = fn;
+        running = n_threads;
+        generation++;
+        start_cv.notify_all();
+        done_cv.wait(lock, [&] { return running == 0; });
+    }
+
+    int get_n_threads() { return n_threads; }
+
+    /**
+     * @brief CPU a worker is pinned to, -1 if the pool is not pinned.
+     */
+    int get_cpu(int thread_id) { return cpus.empty() ? -1 : cpus[thread_id]; }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "core/core_utils.h"
+#include "lib/csr_graph.h"
+#include <sstream>
+
+
+/**
+ * @brief The stringstream parser generate_edges used before graph_parser.h,
+ *        kept as the baseline of the benchmark.
+ */
+long legacy_parse_line(const std::string& csv_line) {
+    std::stringstream ss(csv_line);
+    std::vector<int> values;
+
+    int value;
+    while (ss >> value) {
+        values.push_back(value);
+        if (ss.peek() == ',') {ss.ignore(); }
+    }
+
+    long n_edges = 0;
+    int mod = 0;
+    while (!values.empty()) {
+        if (mod == 1) { n_edges++; }
+        values.erase(values.begin());
+        mod = (mod + 1) % 2;
+    }
+    return n_edges;
+}
+
+
+void print_throughput(std::string parser, long n_bytes, long n_edges, double time_taken) {
+    std::string delim = ",\t";
+    std::cout << parser << delim << n_edges << delim << time_taken << delim
+              << n_bytes / time_taken / 1e6 << std::endl;
+}
+
+
+/**
+ * @brief Measure the throughput of the edge parser on an input graph. The
+ *        executable takes four parameters (--inputFile, --repeat, --nThreads,
+ *        --compareLegacy) and prints the edges parsed, the time taken and the
+ *        throughput in MB/s of every parser. The ingest row maps the file and
+ *        builds the CSR graph on --nThreads threads, the way the all_pairs
+ *        binaries load their input.
+ */
+int main(int argc, char *argv[]) {
+    std::cout << std::scientific << std::setprecision(TIME_PRECISION);
+    cxxopts::Options options(
+        "parse benchmark",
+        "Measure the throughput of the input graph parser"
+    );
+    options.add_options(
+        "",
+        {
+            {"inputFile", "Input graph file path",
+            cxxopts::value<std::string>()->default_value(
+                "./inputs/graph.txt")},
+            {"repeat", "Number of times the file is parsed",
+            cxxopts::value<int>()->default_value("5")},
+            {"nThreads", "Threads used by the mapped ingest",
+            cxxopts::value<int>()->default_value(std::to_string(ingest_threads()))},
+            {"compareLegacy", "Also time the stringstream parser (quadratic in the line length)",
+            cxxopts::value<bool>()->default_value("false")},
+        }
+    );
+
+    auto cl_options = options.parse(argc, argv);
+    std::string input_file_path = cl_options["inputFile"].as<std::string>();
+    int repeat = cl_options["repeat"].as<int>();
+    int n_threads = cl_options["nThreads"].as<int>();
+    bool compare_legacy = cl_options["compareLegacy"].as<bool>();
+
+    if (repeat <= 0 || n_threads <= 0) {
+        std::cout << "Repeat and number of threads must be positive" << std::endl;
+        return 1;
+    }
+
+    std::ifstream inputFile(input_file_path);
+    if (!inputFile.is_open()) {
+        std::cout << "Unable to open file (" << input_file_path << ")" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    long n_bytes = 0;
+    while (std::getline(inputFile, line)) {
+        if (!line.empty()) {
+            n_bytes += line.size() + 1;
+            lines.push_back(line);
+        }
+    }
+    inputFile.close();
+
+    std::cout << "parser,\t\tedges,\t\ttime_taken,\tMB/s\n";
+
+    timer scanner_timer;
+    scanner_timer.start();
+    long n_edges = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (const std::string& csv_line : lines) {
+            const char* begin = csv_line.data();
+            n_edges += parse_edge_line(begin, begin + csv_line.size(), [](int, int) {});
+        }
+    }
+    print_throughput("scanner", n_bytes * repeat, n_edges, scanner_timer.stop());
+
+    timer ingest_timer;
+    ingest_timer.start();
+    long ingest_edges = 0;
+    long mapped_bytes = 0;
+    for (int r = 0; r < repeat; r++) {
+        MappedFile mapped(input_file_path);
+        std::vector<LineSpan> spans = find_lines(mapped.data(), mapped.size(), n_threads);
+        CSRGraph graph;
+        build_csr_graph(mapped.data(), spans, n_threads, graph);
+        ingest_edges += graph.get_n_edges();
+        mapped_bytes += mapped.size();
+    }
+    print_throughput("ingest", mapped_bytes, ingest_edges, ingest_timer.stop());
+
+    if (compare_legacy) {
+        timer legacy_timer;
+        legacy_timer.start();
+        long legacy_edges = 0;
+        for (int r = 0; r < repeat; r++) {
+            for (const std::string& csv_line : lines) { legacy_edges += legacy_parse_line(csv_line); }
+        }
+        print_throughput("stringstream", n_bytes * repeat, legacy_edges, legacy_timer.stop());
+    }
+    return 0;
+}
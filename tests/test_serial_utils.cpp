@@ -1,4 +1,13 @@
+// small buffers, so the matrix_text test formats in many rounds
+#define FORMAT_BUFFER_BYTES 256
+
+#include "../lib/checkpoint_utils.h"
+#include "../lib/dynamic_utils.h"
+#include "../lib/graph_format.h"
+#include "../lib/query_server.h"
 #include "../lib/serial_utils.h"
+#include <string>
+#include <cstdio>
 
 
 bool test_generate_edges() {
@@ -15,6 +24,761 @@ bool test_generate_edges() {
 }
 
 
+bool test_parse_edge_line() {
+    // whitespace and a trailing comma are accepted, a dangling output vertex
+    // is dropped and a non numeric value ends the line
+    std::string csv_line = " 4, 7,2,-1,9,\r";
+    std::vector<int> values;
+    auto collect = [&](int output_vertex, int weight) {
+        values.push_back(output_vertex);
+        values.push_back(weight);
+    };
+    long parsed = parse_edge_line(csv_line.data(), csv_line.data() + csv_line.size(), collect);
+
+    std::string broken_line = "1,2,x,3,4";
+    long parsed_broken = parse_edge_line(
+        broken_line.data(), broken_line.data() + broken_line.size(), collect
+    );
+
+    return parsed == 2 && parsed_broken == 1
+        && values == std::vector<int>({4, 7, 2, -1, 1, 2});
+}
+
+
+bool test_csr_graph() {
+    // empty lines are dropped and the last line has no newline, parallel
+    // edges collapse to the lightest one and targets end up sorted. Every
+    // thread count must build the same graph, including more threads than
+    // bytes.
+    std::string file = "1,5,2,4,1,3\n\n\n0,2,2,3\r\n1,7";
+    int expected_offsets[] = {0, 2, 4, 5};
+    int expected_targets[] = {1, 2, 0, 2, 1};
+    int expected_weights[] = {3, 4, 2, 3, 7};
+
+    bool result = true;
+    for (int n_threads = 1; n_threads <= 40; n_threads++) {
+        std::vector<LineSpan> lines = find_lines(file.data(), file.size(), n_threads);
+        CSRGraph graph;
+        result &= build_csr_graph(file.data(), lines, n_threads, graph);
+        result &= graph.get_n_vertices() == 3 && graph.get_n_edges() == 5;
+        for (int vertex = 0; result && vertex <= 3; vertex++) {
+            result &= graph.get_offsets()[vertex] == expected_offsets[vertex];
+        }
+        for (int edge = 0; result && edge < 5; edge++) {
+            result &= graph.get_target(edge) == expected_targets[edge]
+                && graph.get_weight(edge) == expected_weights[edge];
+        }
+    }
+
+    // edges must stay inside the graph
+    std::string invalid = "1,5\n3,1";
+    std::vector<LineSpan> lines = find_lines(invalid.data(), invalid.size(), 1);
+    CSRGraph graph;
+    return result && !build_csr_graph(invalid.data(), lines, 1, graph);
+}
+
+
+bool test_binary_graph() {
+    // write a graph with one byte weights, read it back and flip a byte
+    std::string file = "1,5,2,4\n0,2\n1,200\n";
+    std::vector<LineSpan> lines = find_lines(file.data(), file.size(), 1);
+    CSRGraph graph;
+    build_csr_graph(file.data(), lines, 1, graph);
+
+    std::string path = "test_binary_graph.bin";
+    std::string error;
+    bool result = write_binary_graph(path, graph, error);
+
+    CSRGraph loaded;
+    {
+        std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>(path);
+        result &= read_binary_graph(mapped, true, loaded, error);
+    }
+    // the mapping outlives the MappedFile pointer while the graph uses it
+    result &= loaded.get_n_vertices() == 3 && loaded.get_n_edges() == 4
+        && loaded.get_target(3) == 1 && loaded.get_weight(3) == 200
+        && std::equal(graph.get_offsets(), graph.get_offsets() + 4, loaded.get_offsets());
+
+    std::fstream corrupt(path, std::ios::binary | std::ios::in | std::ios::out);
+    corrupt.seekp(sizeof(GraphFileHeader) + 4 * sizeof(int64_t));
+    corrupt.put(7);
+    corrupt.close();
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>(path);
+    result &= !read_binary_graph(mapped, true, loaded, error);
+
+    // targets are checked without verify: out of range, then out of order
+    // (vertex 0 has targets 1 and 2)
+    for (int target : {100000000, 2}) {
+        corrupt.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        corrupt.seekp(sizeof(GraphFileHeader) + 4 * sizeof(int64_t));
+        corrupt.write((const char*) &target, sizeof(target));
+        corrupt.close();
+        mapped = std::make_shared<MappedFile>(path);
+        result &= !read_binary_graph(mapped, false, loaded, error)
+            && error == "Invalid binary graph targets";
+    }
+
+    std::remove(path.c_str());
+    return result;
+}
+
+
+bool test_binary_matrix() {
+    // 3 columns, so every row of the matrix is padded
+    Matrix_2D distances(3, INFINITY_INT);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) { if (i <= j) { distances.at(i, j) = i * 3 + j; } }
+    }
+    std::string path = "test_binary_matrix.bin";
+    bool result = write_binary_matrix(&distances, path);
+
+    MappedFile mapped(path);
+    MatrixFileHeader header;
+    result &= mapped.is_open() && mapped.size() == sizeof(header) + 9 * sizeof(int);
+    if (result) {
+        std::memcpy(&header, mapped.data(), sizeof(header));
+        result &= std::memcmp(header.magic, MATRIX_MAGIC, 8) == 0 && header.rows == 3
+            && header.columns == 3 && header.infinity == INFINITY_INT;
+        const int* values = (const int*) (mapped.data() + header.data_offset);
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) { result &= values[i * 3 + j] == distances.at(i, j); }
+        }
+    }
+    std::remove(path.c_str());
+    return result;
+}
+
+
+bool test_matrix_text() {
+    // the formatter must match print_matrix byte for byte
+    Matrix_2D distances(13, INFINITY_INT);
+    int values[] = {0, 7, -3, 99, 100, 12345, INT_MIN, INFINITY_INT - 1, -99};
+    for (int i = 0; i < 13; i++) {
+        for (int j = 0; j < 13; j++) {
+            if ((i + j) % 4 != 0) { distances.at(i, j) = values[(i * 13 + j) % 9]; }
+        }
+    }
+    std::ostringstream expected;
+    distances.print_matrix(expected);
+
+    bool result = true;
+    std::string path = "test_matrix_text.txt";
+    for (int n_threads = 1; n_threads <= 5; n_threads += 2) {
+        result &= write_matrix_text_file(
+            &distances, path, "", n_threads, short_lived_threads(n_threads)
+        );
+        std::ifstream input(path);
+        std::stringstream formatted;
+        formatted << input.rdbuf();
+        result &= formatted.str() == expected.str();
+    }
+    std::remove(path.c_str());
+
+#ifndef _WIN32
+    // printing to a full device must be reported, for the next hops too
+    int full = open("/dev/full", O_WRONLY);
+    if (full >= 0) {
+        std::cout.flush();
+        int saved = dup(1);
+        dup2(full, 1);
+        close(full);
+        NextHopMatrix next_hops(13);
+        next_hops.seed_rows(&distances, 0, 13);
+        bool printed = output_matrix(&distances, "", "text", 1, short_lived_threads(1));
+        bool hops_printed = output_next_hops(&next_hops, "", "text", 1, short_lived_threads(1));
+        std::cout.clear();
+        dup2(saved, 1);
+        close(saved);
+        result &= !printed && !hops_printed;
+    }
+#endif
+    return result;
+}
+
+
+bool test_query_server() {
+    Matrix_2D distances(3, INFINITY_INT);
+    for (int i = 0; i < 3; i++) { distances.at(i, i) = 0; }
+    distances.at(0, 1) = 5;
+    distances.at(2, 0) = 12;
+    std::string path = "test_query_server.bin";
+    bool result = write_binary_matrix(&distances, path);
+
+    MappedMatrix matrix;
+    std::string error;
+    result &= map_binary_matrix(path, matrix, error);
+    if (!result) { return false; }
+    QueryServer server(matrix, 2);
+
+    // the last request is incomplete and left for the next read
+    std::string requests = "d 0 1\nr 2\nb 0 2 2 0\nd 3 0\nd 0";
+    std::string reply;
+    long consumed = server.answer_buffer(false, requests.data(), requests.size(), reply, 1);
+    result &= consumed == (long) requests.size() - 3;
+    result &= reply.compare(0, reply.find("ERR"), "5\n12 INF 0\nINF 12\n") == 0;
+
+    // a longer command word or anything left after the arguments is an error
+    requests = "statsx\nd 0 1 2\nd 0 1x\nr 2 junk\nb 0 1 2\n d 0 1 \r\n";
+    reply.clear();
+    server.answer_buffer(false, requests.data(), requests.size(), reply, 1);
+    std::stringstream replies(reply);
+    std::string line;
+    int errors = 0;
+    while (std::getline(replies, line) && line.compare(0, 3, "ERR") == 0) { errors++; }
+    result &= errors == 5 && line == "5" && !std::getline(replies, line);
+
+    int32_t frame[] = {QUERY_DISTANCES, 2, 0, 1, 2, 0};
+    reply.clear();
+    server.answer_buffer(true, (const char*) frame, sizeof(frame), reply, 0);
+    ReplyFrame header;
+    std::memcpy(&header, reply.data(), sizeof(header));
+    const int32_t* values = (const int32_t*) (reply.data() + sizeof(header));
+    result &= header.status == QUERY_OK && header.count == 2 && values[0] == 5 && values[1] == 12;
+
+    uint64_t total;
+    result &= latency_percentile(std::vector<std::unique_ptr<LatencyHistogram>>(), 0.5, &total) == 0;
+    result &= server.stats().compare(0, 11, "queries 11 ") == 0;
+
+    std::remove(path.c_str());
+    return result;
+}
+
+
+/**
+ * @brief Fill a matrix with a random sparse graph, leaving most entries
+ *        at infinity.
+ */
+void fill_random_graph(Matrix_2D* distances, unsigned int seed) {
+    srand(seed);
+    int n = distances->get_dimension();
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (i == j) {
+                distances->set_matrix_value(i, j, 0);
+            } else if (rand() % 8 == 0) {
+                distances->set_matrix_value(i, j, 1 + rand() % 100);
+            }
+        }
+    }
+}
+
+
+bool matrices_equal(Matrix_2D* a, Matrix_2D* b) {
+    int n = a->get_dimension();
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (a->get_matrix_value(i, j) != b->get_matrix_value(i, j)) { return false; }
+        }
+    }
+    return true;
+}
+
+
+bool test_blocked_floyd_warshall() {
+    // 37 is not a multiple of the tile size, so the last tiles are partial
+    Matrix_2D expected(37, INFINITY_INT);
+    Matrix_2D actual(37, INFINITY_INT);
+    fill_random_graph(&expected, 431);
+    fill_random_graph(&actual, 431);
+
+    floyd_warshall(&expected);
+    blocked_floyd_warshall(&actual, 8);
+
+    return matrices_equal(&expected, &actual);
+}
+
+
+/**
+ * @brief Check every path of the next hops against the graph: it follows
+ *        edges, and its weight is the distance.
+ */
+bool paths_match(Matrix_2D* graph, Matrix_2D* distances, NextHopMatrix* next_hops) {
+    int n = graph->get_dimension();
+    for (int from = 0; from < n; from++) {
+        for (int to = 0; to < n; to++) {
+            std::vector<int> path = reconstruct_path(*next_hops, from, to);
+            if (path.empty()) {
+                if (distances->at(from, to) < INFINITY_INT) { return false; }
+                continue;
+            }
+            if (path.front() != from || path.back() != to) { return false; }
+            long weight = 0;
+            for (size_t step = 1; step < path.size(); step++) {
+                int edge = graph->at(path[step - 1], path[step]);
+                if (edge >= INFINITY_INT) { return false; }
+                weight += edge;
+            }
+            if (weight != distances->at(from, to)) { return false; }
+        }
+    }
+    return true;
+}
+
+
+bool test_reconstruct_path() {
+    // 300 vertices need 2 byte next hops
+    bool result = true;
+    for (int n : {37, 300}) {
+        Matrix_2D graph(n, INFINITY_INT);
+        Matrix_2D expected(n, INFINITY_INT);
+        Matrix_2D naive(n, INFINITY_INT);
+        Matrix_2D blocked(n, INFINITY_INT);
+        fill_random_graph(&graph, 99);
+        fill_random_graph(&expected, 99);
+        fill_random_graph(&naive, 99);
+        fill_random_graph(&blocked, 99);
+
+        NextHopMatrix naive_hops(n);
+        NextHopMatrix blocked_hops(n);
+        naive_hops.seed_rows(&naive, 0, n);
+        blocked_hops.seed_rows(&blocked, 0, n);
+        result &= naive_hops.get_width() == (n < 256 ? 1 : 2);
+
+        floyd_warshall(&expected);
+        floyd_warshall(&naive, &naive_hops);
+        blocked_floyd_warshall(&blocked, 8, &blocked_hops);
+
+        result &= matrices_equal(&expected, &naive) && matrices_equal(&expected, &blocked);
+        result &= paths_match(&graph, &naive, &naive_hops);
+        result &= paths_match(&graph, &blocked, &blocked_hops);
+    }
+    return result;
+}
+
+
+/**
+ * @brief CSR graph of a random edge list text, n vertices with weights
+ *        base + h[u] - h[v] for random potentials h, negative for some edges
+ *        when with_negative is set but never on a cycle.
+ */
+void build_random_csr(int n, unsigned int seed, bool with_negative, CSRGraph& graph) {
+    srand(seed);
+    std::vector<int> h(n, 0);
+    for (int v = 0; v < n && with_negative; v++) { h[v] = rand() % 30; }
+    std::string file;
+    for (int u = 0; u < n; u++) {
+        size_t line_start = file.size();
+        for (int v = 0; v < n; v++) {
+            if (rand() % 10 != 0) { continue; }
+            file += std::to_string(v) + "," + std::to_string(rand() % 50 + h[u] - h[v]) + ",";
+        }
+        // empty lines are dropped, a 0 weight self loop keeps the vertex
+        if (file.size() == line_start) { file += std::to_string(u) + ",0"; }
+        file += "\n";
+    }
+    std::vector<LineSpan> lines = find_lines(file.data(), file.size(), 1);
+    build_csr_graph(file.data(), lines, 1, graph);
+}
+
+
+bool test_dijkstra_rows() {
+    // repeated Dijkstra, with the binary heap and with the buckets of dial,
+    // must match Floyd-Warshall with and without the Johnson potentials of
+    // negative weights, and its next hops must follow shortest paths
+    bool result = true;
+    std::string engines[] = {"dijkstra", "dial"};
+    for (std::string engine : engines) {
+        for (int with_negative = 0; with_negative <= 1; with_negative++) {
+            int n = 70;
+            CSRGraph graph;
+            build_random_csr(n, 5 + with_negative, with_negative, graph);
+            Matrix_2D edges(n, INFINITY_INT);
+            Matrix_2D expected(n, INFINITY_INT);
+            for (int vertex = 0; vertex < n; vertex++) {
+                seed_distance_row(edges.row(vertex), graph, vertex, 0, n);
+                seed_distance_row(expected.row(vertex), graph, vertex, 0, n);
+            }
+            floyd_warshall(&expected);
+
+            std::vector<int64_t> potentials;
+            int n_buckets;
+            result &= prepare_dijkstra(graph, engine, potentials, n_buckets);
+            result &= potentials.empty() == !with_negative;
+            result &= (n_buckets > 0) == (engine == "dial");
+            Matrix_2D actual(n, INFINITY_INT);
+            NextHopMatrix next_hops(n);
+            std::atomic<int> next_source(0);
+            result &= dijkstra_rows(
+                graph, &actual, potentials, n_buckets, next_source, &next_hops
+            ) == n;
+            result &= matrices_equal(&expected, &actual);
+            result &= paths_match(&edges, &actual, &next_hops);
+        }
+    }
+
+    // weights above DIAL_MAX_WEIGHT fall back to the binary heap
+    std::string heavy = "1," + std::to_string(DIAL_MAX_WEIGHT + 1) + "\n0,1";
+    std::vector<LineSpan> lines = find_lines(heavy.data(), heavy.size(), 1);
+    CSRGraph graph;
+    build_csr_graph(heavy.data(), lines, 1, graph);
+    std::vector<int64_t> potentials;
+    int n_buckets;
+    result &= prepare_dijkstra(graph, "dial", potentials, n_buckets) && n_buckets == 0;
+    return result;
+}
+
+
+bool test_select_engine() {
+    // a dense graph goes to Floyd-Warshall, a large sparse one with small
+    // weights to the buckets of dial and with large weights to the heap. A
+    // dense graph with a negative weight goes to Johnson's dijkstra.
+    std::string dense, sparse, heavy, negative;
+    for (int u = 0; u < 300; u++) {
+        for (int v = 0; v < 300; v++) {
+            dense += std::to_string(v) + ",7,";
+            negative += std::to_string(v) + (u == 0 && v == 1 ? ",-2," : ",7,");
+        }
+        dense += "\n";
+        negative += "\n";
+    }
+    for (int u = 0; u < 2000; u++) {
+        sparse += std::to_string((u + 1) % 2000) + ",3\n";
+        heavy += std::to_string((u + 1) % 2000) + ",100000\n";
+    }
+    std::string files[] = {dense, sparse, heavy, negative};
+    std::string expected[] = {"blocked", "dial", "dijkstra", "dijkstra"};
+    bool result = true;
+    for (int i = 0; i < 4; i++) {
+        std::vector<LineSpan> lines = find_lines(files[i].data(), files[i].size(), 1);
+        CSRGraph graph;
+        result &= build_csr_graph(files[i].data(), lines, 1, graph);
+        EngineChoice choice = select_engine(graph, 1, false);
+        int n = graph.get_n_vertices();
+        result &= choice.engine == expected[i] && choice.matrix_bytes == (size_t) n * n * 4;
+    }
+    return result;
+}
+
+
+/**
+ * @brief Shortest distances of a CSR graph, solved with Floyd-Warshall.
+ */
+void solve_csr(const CSRGraph& graph, Matrix_2D* distances) {
+    for (int vertex = 0; vertex < graph.get_n_vertices(); vertex++) {
+        seed_distance_row(distances->row(vertex), graph, vertex, 0, graph.get_n_vertices());
+    }
+    floyd_warshall(distances);
+}
+
+
+bool test_pruned_floyd_warshall() {
+    // 3 has no out-edges, 4 no in-edges and 5 neither: their pivots are
+    // skipped, and the result and next hops must not change
+    std::string file = "1,4,2,1\n3,2\n1,1,3,7\n3,0\n0,3\n5,0\n";
+    CSRGraph graph;
+    std::vector<LineSpan> lines = find_lines(file.data(), file.size(), 1);
+    build_csr_graph(file.data(), lines, 1, graph);
+    std::vector<bool> prunable = prunable_pivots(graph);
+    bool result = prunable == std::vector<bool>({false, false, false, true, true, true});
+
+    bool first = true;
+    for (int n : {6, 90}) {
+        if (!first) { build_random_csr(n, 17, false, graph); }
+        first = false;
+        prunable = prunable_pivots(graph);
+        Matrix_2D expected(n, INFINITY_INT);
+        Matrix_2D actual(n, INFINITY_INT);
+        for (int vertex = 0; vertex < n; vertex++) {
+            seed_distance_row(expected.row(vertex), graph, vertex, 0, n);
+            seed_distance_row(actual.row(vertex), graph, vertex, 0, n);
+        }
+        NextHopMatrix expected_hops(n);
+        NextHopMatrix actual_hops(n);
+        expected_hops.seed_rows(&expected, 0, n);
+        actual_hops.seed_rows(&actual, 0, n);
+
+        PruneStats stats;
+        floyd_warshall(&expected, &expected_hops);
+        floyd_warshall(&actual, &actual_hops, &prunable, &stats);
+        result &= matrices_equal(&expected, &actual);
+        result &= std::memcmp(expected_hops.data(), actual_hops.data(), (size_t) n * n) == 0;
+        result &= stats.pivots == n && stats.rows_relaxed < (int64_t) n * n;
+        result &= stats.pivots_skipped == (n == 6 ? 3 : 0);
+    }
+
+    // no pruning with a negative weight
+    file = "1,3\n0,-2\n";
+    lines = find_lines(file.data(), file.size(), 1);
+    build_csr_graph(file.data(), lines, 1, graph);
+    return result && prunable_pivots(graph).empty();
+}
+
+
+bool test_scc_floyd_warshall() {
+    // {0, 1} and {2, 3, 4} are cycles, 5 only has a self loop, and the only
+    // edge between components goes from 2 to 1
+    std::string file = "1,2\n0,3\n3,1,1,5\n4,5\n2,1\n5,0\n";
+    CSRGraph graph;
+    std::vector<LineSpan> lines = find_lines(file.data(), file.size(), 1);
+    build_csr_graph(file.data(), lines, 1, graph);
+    SccDecomposition scc = decompose_graph(graph);
+    bool result = scc.n_components == 3 && scc.n_levels == 2;
+    result &= scc.component[0] == scc.component[1] && scc.component[2] == scc.component[4];
+    result &= scc.level[scc.component[2]] == 1 && scc.level[scc.component[5]] == 0;
+    result &= scc.cross_edges.size() == 1 && scc.cross_edges[0].from == 2;
+
+    // clusters of 10 vertices with edges only to the same or a later cluster
+    // must match Floyd-Warshall, negative weights included, with an unreachable
+    // pair staying at infinity
+    ThreadRunner run_here = [](std::function<void(int)> fn) { fn(0); };
+    ComponentSolver solve = [](Matrix_2D* local, NextHopMatrix* local_hops) {
+        blocked_floyd_warshall(local, 4, local_hops);
+    };
+    int n = 80;
+    for (bool with_negative : {false, true}) {
+        srand(11 + with_negative);
+        std::vector<int> h(n, 0);
+        for (int v = 0; v < n && with_negative; v++) { h[v] = rand() % 30; }
+        file.clear();
+        for (int u = 0; u < n; u++) {
+            size_t line_start = file.size();
+            for (int v = u / 10 * 10; v < n; v++) {
+                if (v == u || rand() % (v / 10 == u / 10 ? 3 : 40) != 0) { continue; }
+                file += std::to_string(v) + "," + std::to_string(rand() % 50 + h[u] - h[v]) + ",";
+            }
+            if (file.size() == line_start) { file += std::to_string(u) + ",0"; }
+            file += "\n";
+        }
+        lines = find_lines(file.data(), file.size(), 1);
+        build_csr_graph(file.data(), lines, 1, graph);
+        Matrix_2D edges(n, INFINITY_INT);
+        Matrix_2D expected(n, INFINITY_INT);
+        for (int vertex = 0; vertex < n; vertex++) {
+            seed_distance_row(edges.row(vertex), graph, vertex, 0, n);
+        }
+        std::vector<int64_t> potentials;
+        int n_buckets;
+        prepare_dijkstra(graph, "dijkstra", potentials, n_buckets);
+        std::atomic<int> next_source(0);
+        dijkstra_rows(graph, &expected, potentials, n_buckets, next_source, NULL);
+
+        scc = decompose_graph(graph);
+        SccStats stats(1);
+        Matrix_2D actual(n, 0);
+        NextHopMatrix next_hops(n);
+        result &= scc.n_components >= 8;
+        result &= scc_floyd_warshall(graph, scc, &actual, &next_hops, 4, 1, run_here, solve, &stats);
+        result &= matrices_equal(&expected, &actual);
+        result &= paths_match(&edges, &actual, &next_hops);
+        result &= actual.row(n - 1)[0] == INFINITY_INT;
+    }
+
+    // a negative cycle inside a component is reported
+    file = "1,2\n0,-3\n";
+    lines = find_lines(file.data(), file.size(), 1);
+    build_csr_graph(file.data(), lines, 1, graph);
+    scc = decompose_graph(graph);
+    SccStats stats(1);
+    Matrix_2D actual(2, 0);
+    return result && !scc_floyd_warshall(graph, scc, &actual, NULL, 4, 1, run_here, solve, &stats);
+}
+
+
+bool test_apply_edge_updates() {
+    // raising, deleting, inserting and lowering edges of a solved matrix must
+    // match solving the updated graph, with every changed entry reported once
+    // against its old distance
+    bool result = true;
+    for (int with_negative = 0; with_negative <= 1; with_negative++) {
+        int n = 45;
+        CSRGraph graph;
+        build_random_csr(n, 23 + with_negative, with_negative, graph);
+        Matrix_2D before(n, INFINITY_INT);
+        solve_csr(graph, &before);
+        Matrix_2D updated(n, INFINITY_INT);
+        solve_csr(graph, &updated);
+
+        // raise and delete edges of the first vertices, then lower and insert
+        std::string file;
+        for (int u = 0; u < 6; u++) {
+            int64_t e = graph.edges_begin(u);
+            if (e == graph.edges_end(u)) { continue; }
+            std::string edge = std::to_string(u) + "," + std::to_string(graph.get_target(e));
+            file += u % 2 == 0 ? edge + "\n" : edge + "," + std::to_string(graph.get_weight(e) + 40) + "\n";
+        }
+        file += "\n3,40,2\n7,7,-5\n12,30,1\n3,40,90\n";
+        std::vector<EdgeUpdate> updates;
+        std::string error;
+        result &= parse_edge_updates(file.data(), file.size(), n, updates, error);
+
+        CSRGraph expected_graph = graph;
+        for (const EdgeUpdate& update : updates) {
+            expected_graph = with_edge_weight(expected_graph, update.from, update.to, update.weight);
+        }
+        Matrix_2D expected(n, INFINITY_INT);
+        solve_csr(expected_graph, &expected);
+
+        std::vector<DistanceChange> changes;
+        int64_t rows_recomputed = 0;
+        result &= apply_edge_updates(
+            &updated, &graph, updates, 3, short_lived_threads(3), changes, rows_recomputed, error
+        );
+        result &= matrices_equal(&expected, &updated);
+        result &= rows_recomputed > 0 && rows_recomputed < (int64_t) n * 6;
+        for (int u = 0; u < n; u++) {
+            for (int v = 0; v < n; v++) {
+                result &= edge_weight(graph, u, v) == edge_weight(expected_graph, u, v);
+            }
+        }
+
+        size_t expected_changes = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) { expected_changes += before.at(i, j) != expected.at(i, j); }
+        }
+        result &= changes.size() == expected_changes;
+        for (size_t c = 0; c < changes.size(); c++) {
+            const DistanceChange& change = changes[c];
+            result &= change.old_distance == before.at(change.from, change.to)
+                && change.new_distance == expected.at(change.from, change.to);
+            result &= c == 0 || changes[c - 1].from < change.from
+                || (changes[c - 1].from == change.from && changes[c - 1].to < change.to);
+        }
+    }
+
+    // without the graph, deletions and negative cycles are rejected, and a
+    // vertex outside the matrix too
+    Matrix_2D distances(3, INFINITY_INT);
+    for (int i = 0; i < 3; i++) { distances.set_matrix_value(i, i, 0); }
+    std::vector<DistanceChange> changes;
+    int64_t rows_recomputed = 0;
+    std::string error;
+    std::vector<EdgeUpdate> updates = {{0, 1, 5}, {1, 2, 1}};
+    result &= apply_edge_updates(
+        &distances, NULL, updates, 2, short_lived_threads(2), changes, rows_recomputed, error
+    );
+    result &= distances.at(0, 2) == 6 && changes.size() == 3;
+    updates.assign(1, {2, 0, -7});
+    result &= !apply_edge_updates(
+        &distances, NULL, updates, 2, short_lived_threads(2), changes, rows_recomputed, error
+    );
+    updates.assign(1, {0, 1, INFINITY_INT});
+    result &= !apply_edge_updates(
+        &distances, NULL, updates, 2, short_lived_threads(2), changes, rows_recomputed, error
+    );
+    std::string outside = "1,3,3\n";
+    return result && !parse_edge_updates(outside.data(), outside.size(), 3, updates, error);
+}
+
+
+bool test_checkpoint() {
+    // checkpoints after pivots 17 and 34 of 37, written in two parts
+    int n = 37;
+    Matrix_2D expected(n, INFINITY_INT);
+    Matrix_2D distances(n, INFINITY_INT);
+    fill_random_graph(&expected, 23);
+    fill_random_graph(&distances, 23);
+    NextHopMatrix next_hops(n);
+    next_hops.seed_rows(&distances, 0, n);
+    floyd_warshall(&expected);
+
+    std::string path = "test_checkpoint.ckpt";
+    CheckpointHeader header = checkpoint_header(n, 42, 0, n, 0, n, next_hops.get_width());
+    CheckpointWriter writer(path, header, 17, 2);
+    bool result = writer.due(17) && writer.due(34) && !writer.due(16) && !writer.due(51);
+    for (int pivot : {17, 34}) {
+        update_tile(&distances, 0, n, 0, n, pivot - 17, pivot, &next_hops);
+        writer.snapshot_part(&distances, &next_hops, 0, 20, pivot);
+        writer.snapshot_part(&distances, &next_hops, 20, n, pivot);
+    }
+    writer.finish();
+    result &= writer.get_written() == 2 && writer.get_failed() == 0;
+
+    // resume from the newest one and finish the pivots
+    std::string file;
+    Matrix_2D resumed(n, INFINITY_INT);
+    NextHopMatrix resumed_hops(n);
+    result &= latest_checkpoint(path, header, file) == 34 && file == path;
+    result &= read_checkpoint_rows(file, &resumed, &resumed_hops, 0, n);
+    update_tile(&resumed, 0, n, 0, n, 34, n, &resumed_hops);
+    update_tile(&distances, 0, n, 0, n, 34, n, &next_hops);
+    result &= matrices_equal(&expected, &resumed);
+    result &= std::memcmp(resumed_hops.data(), next_hops.data(), (size_t) n * n) == 0;
+
+    // another graph or --paths setting does not match, a truncated file
+    // falls back to the previous checkpoint
+    CheckpointHeader other = checkpoint_header(n, 43, 0, n, 0, n, next_hops.get_width());
+    result &= checkpoint_pivot(path, other) == -1;
+    other = checkpoint_header(n, 42, 0, n, 0, n, 0);
+    result &= checkpoint_pivot(path, other) == -1;
+    FILE* truncated = std::fopen(path.c_str(), "wb");
+    std::fwrite(&header, sizeof(header), 1, truncated);
+    std::fclose(truncated);
+    result &= latest_checkpoint(path, header, file) == 17 && file == previous_checkpoint_path(path);
+
+    writer.remove_files();
+    return result && checkpoint_pivot(previous_checkpoint_path(path), header) == -1;
+}
+
+
+bool test_checkpoint_parts() {
+    // a thread past pruned pivots brings its part of pivot 34 before the
+    // other part of pivot 17 arrives, it must wait for the snapshot of 17
+    int n = 37;
+    Matrix_2D at_17(n, INFINITY_INT);
+    Matrix_2D at_34(n, INFINITY_INT);
+    Matrix_2D expected(n, INFINITY_INT);
+    fill_random_graph(&at_17, 29);
+    fill_random_graph(&at_34, 29);
+    fill_random_graph(&expected, 29);
+    NextHopMatrix hops_17(n);
+    NextHopMatrix hops_34(n);
+    hops_17.seed_rows(&at_17, 0, n);
+    hops_34.seed_rows(&at_34, 0, n);
+    update_tile(&at_17, 0, n, 0, n, 0, 17, &hops_17);
+    update_tile(&at_34, 0, n, 0, n, 0, 34, &hops_34);
+    floyd_warshall(&expected);
+
+    std::string path = "test_checkpoint_parts.ckpt";
+    CheckpointHeader header = checkpoint_header(n, 42, 0, n, 0, n, hops_17.get_width());
+    CheckpointWriter writer(path, header, 17, 2);
+    writer.snapshot_part(&at_17, &hops_17, 0, 20, 17);
+    std::thread ahead([&] { writer.snapshot_part(&at_34, &hops_34, 0, 20, 34); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    writer.snapshot_part(&at_17, &hops_17, 20, n, 17);
+    writer.snapshot_part(&at_34, &hops_34, 20, n, 34);
+    ahead.join();
+    writer.finish();
+    bool result = writer.get_written() == 2 && writer.get_failed() == 0;
+
+    // both checkpoints resume to the result
+    std::string files[] = {path, previous_checkpoint_path(path)};
+    int pivots[] = {34, 17};
+    for (int i = 0; i < 2; i++) {
+        Matrix_2D resumed(n, INFINITY_INT);
+        NextHopMatrix resumed_hops(n);
+        result &= checkpoint_pivot(files[i], header) == pivots[i];
+        result &= read_checkpoint_rows(files[i], &resumed, &resumed_hops, 0, n);
+        update_tile(&resumed, 0, n, 0, n, pivots[i], n, &resumed_hops);
+        result &= matrices_equal(&expected, &resumed);
+    }
+
+    writer.remove_files();
+    return result;
+}
+
+
+bool test_min_plus_kernels() {
+    // every kernel this CPU supports must match the scalar reference,
+    // 53 columns leaves a remainder for every vector width
+    Matrix_2D expected(53, INFINITY_INT);
+    fill_random_graph(&expected, 7);
+    set_min_plus_kernel("scalar");
+    floyd_warshall(&expected);
+
+    std::string kernels[] = {"sse4.1", "avx2", "avx512"};
+    bool result = true;
+    for (std::string kernel : kernels) {
+        if (!set_min_plus_kernel(kernel)) { continue; }
+        Matrix_2D actual(53, INFINITY_INT);
+        fill_random_graph(&actual, 7);
+        floyd_warshall(&actual);
+        result &= matrices_equal(&expected, &actual);
+    }
+    set_min_plus_kernel(detect_min_plus_kernel());
+    return result;
+}
+
+
 void print_result(std::string test_name, bool test_status) {
     std::string success = test_status ? "PASS" : "FAIL";
     std::cout << "Test " << test_name << "..." << success << std::endl;
@@ -22,7 +786,23 @@ void print_result(std::string test_name, bool test_status) {
 
 
 int main(int argc, char* argv[]) {
-    print_result("generate_edges", test_generate_edges);
+    print_result("generate_edges", test_generate_edges());
+    print_result("parse_edge_line", test_parse_edge_line());
+    print_result("csr_graph", test_csr_graph());
+    print_result("binary_graph", test_binary_graph());
+    print_result("binary_matrix", test_binary_matrix());
+    print_result("matrix_text", test_matrix_text());
+    print_result("query_server", test_query_server());
+    print_result("blocked_floyd_warshall", test_blocked_floyd_warshall());
+    print_result("reconstruct_path", test_reconstruct_path());
+    print_result("dijkstra_rows", test_dijkstra_rows());
+    print_result("select_engine", test_select_engine());
+    print_result("pruned_floyd_warshall", test_pruned_floyd_warshall());
+    print_result("scc_floyd_warshall", test_scc_floyd_warshall());
+    print_result("apply_edge_updates", test_apply_edge_updates());
+    print_result("checkpoint", test_checkpoint());
+    print_result("checkpoint_parts", test_checkpoint_parts());
+    print_result("min_plus_kernels", test_min_plus_kernels());
 
-    return 0;   
-}
\ No newline at end of file
+    return 0;
+}
@@ -95,7 +95,7 @@ def serial_tests():
             "Serial Test 2: all_pairs_serial small graph",
             "all_pairs_serial",
             "./tests/test_outputs/small_graph.txt",
-            2,
+            3,
             args=["--inputFile", "./tests/test_inputs/small_graph.txt"],
             is_integration=True
         ),
@@ -103,7 +103,7 @@ def serial_tests():
             "Serial Test 3: all_pairs_serial medium graph",
             "all_pairs_serial",
             "./tests/test_outputs/medium_graph.txt",
-            2,
+            3,
             args=["--inputFile", "./tests/test_inputs/medium_graph.txt"],
             is_integration=True
         ),
@@ -111,7 +111,7 @@ def serial_tests():
             "Serial Test 4: all_pairs_serial 100 graph",
             "all_pairs_serial",
             "./tests/test_outputs/100_graph.txt",
-            2,
+            3,
             args=["--inputFile", "./tests/test_inputs/100_graph.txt"],
             is_integration=True,
             show_output=False
@@ -120,10 +120,154 @@ def serial_tests():
             "Serial Test 5: all_pairs_serial 1TH vertices, 50 edges graph",
             "all_pairs_serial",
             "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
-            2,
+            3,
             args=["--inputFile", "./tests/test_inputs/1TH_vertices_50_edges_graph.txt"],
             is_integration=True,
             show_output=False
+        ),
+        TestCase(
+            "Serial Test 6: all_pairs_serial blocked engine small graph, partial tiles",
+            "all_pairs_serial",
+            "./tests/test_outputs/small_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/small_graph.txt",
+                "--engine", "blocked", "--tileSize", "3"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 7: all_pairs_serial blocked engine medium graph, partial tiles",
+            "all_pairs_serial",
+            "./tests/test_outputs/medium_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/medium_graph.txt",
+                "--engine", "blocked", "--tileSize", "4"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 8: all_pairs_serial blocked engine 100 graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/100_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/100_graph.txt",
+                "--engine", "blocked", "--tileSize", "16"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Serial Test 9: all_pairs_serial blocked engine 1TH vertices, 50 edges graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--engine", "blocked"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Serial Test 10: all_pairs_serial blocked engine empty graph",
+            "all_pairs_serial",
+            "",
+            0,
+            args=[
+                "--inputFile", "./tests/test_inputs/empty_graph.txt",
+                "--engine", "blocked"
+            ]
+        ),
+        TestCase(
+            "Serial Test 11: all_pairs_serial dijkstra engine medium graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/medium_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/medium_graph.txt",
+                "--engine", "dijkstra"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 12: all_pairs_serial dijkstra engine 1TH vertices, 50 edges graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--engine", "dijkstra"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Serial Test 13: all_pairs_serial dial engine 100 graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/100_graph.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/100_graph.txt",
+                "--engine", "dial"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Serial Test 14: all_pairs_serial auto engine 100 graph",
+            "all_pairs_serial",
+            "./tests/test_outputs/100_graph.txt",
+            3,
+            args=[
+                "--inputFile", "./tests/test_inputs/100_graph.txt",
+                "--engine", "auto"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Serial Test 15: all_pairs_serial graph with sinks and sources, pruned pivots",
+            "all_pairs_serial",
+            "./tests/test_outputs/sinks_graph.txt",
+            3,
+            args=["--inputFile", "./tests/test_inputs/sinks_graph.txt"],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 16: all_pairs_serial scc engine graph with sinks and sources",
+            "all_pairs_serial",
+            "./tests/test_outputs/sinks_graph.txt",
+            3,
+            args=[
+                "--inputFile", "./tests/test_inputs/sinks_graph.txt",
+                "--engine", "scc"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 17: all_pairs_serial dijkstra engine negative weight DAG",
+            "all_pairs_serial",
+            "./tests/test_outputs/negative_dag.txt",
+            2,
+            args=[
+                "--inputFile", "./tests/test_inputs/negative_dag.txt",
+                "--engine", "dijkstra"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Serial Test 18: all_pairs_serial auto engine negative weight DAG",
+            "all_pairs_serial",
+            "./tests/test_outputs/negative_dag.txt",
+            3,
+            args=[
+                "--inputFile", "./tests/test_inputs/negative_dag.txt",
+                "--engine", "auto"
+            ],
+            is_integration=True
         )
     ]
 
@@ -136,7 +280,7 @@ def parallel_tests():
             "Parallel Test 0: all_pairs_parallel small graph with one thread",
             "all_pairs_parallel",
             "./tests/test_outputs/small_graph.txt",
-            4,
+            5,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/small_graph.txt",
@@ -149,7 +293,7 @@ def parallel_tests():
             "Parallel Test 1: all_pairs_parallel small graph with two threads",
             "all_pairs_parallel",
             "./tests/test_outputs/small_graph.txt",
-            5,
+            6,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/small_graph.txt",
@@ -162,7 +306,7 @@ def parallel_tests():
             "Parallel Test 2: all_pairs_parallel small graph with four threads",
             "all_pairs_parallel",
             "./tests/test_outputs/small_graph.txt",
-            7,
+            8,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/small_graph.txt",
@@ -175,7 +319,7 @@ def parallel_tests():
             "Parallel Test 3: all_pairs_parallel small graph with five threads",
             "all_pairs_parallel",
             "./tests/test_outputs/small_graph.txt",
-            8,
+            9,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/small_graph.txt",
@@ -188,7 +332,7 @@ def parallel_tests():
             "Parallel Test 4: all_pairs_parallel medium graph with one thread",
             "all_pairs_parallel",
             "./tests/test_outputs/medium_graph.txt",
-            4,
+            5,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/medium_graph.txt",
@@ -201,7 +345,7 @@ def parallel_tests():
             "Parallel Test 5: all_pairs_parallel medium graph with two threads",
             "all_pairs_parallel",
             "./tests/test_outputs/medium_graph.txt",
-            5,
+            6,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/medium_graph.txt",
@@ -214,7 +358,7 @@ def parallel_tests():
             "Parallel Test 6: all_pairs_parallel medium graph with 9 thread",
             "all_pairs_parallel",
             "./tests/test_outputs/medium_graph.txt",
-            12,
+            13,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/medium_graph.txt",
@@ -227,7 +371,7 @@ def parallel_tests():
             "Parallel Test 7: all_pairs_parallel 100 graph with one thread",
             "all_pairs_parallel",
             "./tests/test_outputs/100_graph.txt",
-            4,
+            5,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/100_graph.txt",
@@ -241,7 +385,7 @@ def parallel_tests():
             "Parallel Test 8: all_pairs_parallel 100 graph with two thread",
             "all_pairs_parallel",
             "./tests/test_outputs/100_graph.txt",
-            5,
+            6,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/100_graph.txt",
@@ -255,7 +399,7 @@ def parallel_tests():
             "Parallel Test 9: all_pairs_parallel 100 graph with five thread",
             "all_pairs_parallel",
             "./tests/test_outputs/100_graph.txt",
-            8,
+            9,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/100_graph.txt",
@@ -269,7 +413,7 @@ def parallel_tests():
             "Parallel Test 10: all_pairs_parallel 1TH vertices, 50 edges graph with one thread",
             "all_pairs_parallel",
             "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
-            4,
+            5,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
@@ -283,7 +427,7 @@ def parallel_tests():
             "Parallel Test 11: all_pairs_parallel 1TH vertices, 50 edges graph with two threads",
             "all_pairs_parallel",
             "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
-            5,
+            6,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
@@ -297,7 +441,7 @@ def parallel_tests():
             "Parallel Test 12: all_pairs_parallel 1TH vertices, 50 edges graph with 4 threads",
             "all_pairs_parallel",
             "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
-            7,
+            8,
             args=[
                 "--inputFile", 
                 "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
@@ -306,6 +450,476 @@ def parallel_tests():
             ],
             is_integration=True,
             show_output=False
+        ),
+        TestCase(
+            "Parallel Test 13: all_pairs_parallel inplace engine small graph with four threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/small_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/small_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "inplace"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 14: all_pairs_parallel inplace engine medium graph with 9 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            13,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "9",
+                "--engine",
+                "inplace"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 15: all_pairs_parallel inplace engine 100 graph with five threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            9,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "5",
+                "--engine",
+                "inplace"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 16: all_pairs_parallel inplace engine 1TH vertices, 50 edges graph with 4 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "inplace"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 17: all_pairs_parallel blocked engine small graph with four threads, partial tiles",
+            "all_pairs_parallel",
+            "./tests/test_outputs/small_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/small_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "blocked",
+                "--tileSize",
+                "3"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 18: all_pairs_parallel blocked engine medium graph with 9 threads, partial tiles",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            12,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "9",
+                "--engine",
+                "blocked",
+                "--tileSize",
+                "4"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 19: all_pairs_parallel blocked engine 100 graph with five threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "5",
+                "--engine",
+                "blocked",
+                "--tileSize",
+                "16"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 20: all_pairs_parallel blocked engine 1TH vertices, 50 edges graph with 4 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "blocked"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 21: all_pairs_parallel spin barrier, inplace engine medium graph with 9 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            13,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "9",
+                "--engine",
+                "inplace",
+                "--barrier",
+                "spin"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 22: all_pairs_parallel tournament barrier, inplace engine medium graph with 9 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            13,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "9",
+                "--engine",
+                "inplace",
+                "--barrier",
+                "tournament"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 23: all_pairs_parallel spin barrier, copy engine 100 graph with five threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            9,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "5",
+                "--engine",
+                "copy",
+                "--barrier",
+                "spin"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 24: all_pairs_parallel tournament barrier, copy engine 100 graph with five threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            9,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "5",
+                "--engine",
+                "copy",
+                "--barrier",
+                "tournament"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 25: all_pairs_parallel compact affinity, inplace engine medium graph with 4 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "inplace",
+                "--affinity",
+                "compact"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 26: all_pairs_parallel list affinity, blocked engine 100 graph with 2 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            5,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "2",
+                "--engine",
+                "blocked",
+                "--affinity",
+                "list",
+                "--cpuList",
+                "0"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 27: all_pairs_parallel dijkstra engine small graph with four threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/small_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/small_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "dijkstra"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 28: all_pairs_parallel dijkstra engine 1TH vertices, 50 edges graph with 3 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            6,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--nThreads",
+                "3",
+                "--engine",
+                "dijkstra"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 29: all_pairs_parallel dial engine 1TH vertices, 50 edges graph with 4 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "dial"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 30: all_pairs_parallel auto engine medium graph with 3 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "3",
+                "--engine",
+                "auto"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 31: all_pairs_parallel inplace engine 100 graph with 3 threads, checkpoints every 16 pivots",
+            "all_pairs_parallel",
+            "./tests/test_outputs/100_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/100_graph.txt",
+                "--nThreads",
+                "3",
+                "--engine",
+                "inplace",
+                "--checkpointFile",
+                "./tests/parallel_test_31.ckpt",
+                "--checkpointInterval",
+                "16"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 32: all_pairs_parallel blocked engine medium graph with 2 threads, checkpoints and resume",
+            "all_pairs_parallel",
+            "./tests/test_outputs/medium_graph.txt",
+            6,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/medium_graph.txt",
+                "--nThreads",
+                "2",
+                "--engine",
+                "blocked",
+                "--tileSize",
+                "4",
+                "--checkpointFile",
+                "./tests/parallel_test_32.ckpt",
+                "--checkpointInterval",
+                "3",
+                "--resume"
+            ],
+            is_integration=True
+        ),
+        TestCase(
+            "Parallel Test 33: all_pairs_parallel copy engine graph with sinks and sources with 3 threads, pruned pivots",
+            "all_pairs_parallel",
+            "./tests/test_outputs/sinks_graph.txt",
+            7,
+            args=["--inputFile", "./tests/test_inputs/sinks_graph.txt", "--nThreads", "3"],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 34: all_pairs_parallel inplace engine graph with sinks and sources with 4 threads, pruned pivots",
+            "all_pairs_parallel",
+            "./tests/test_outputs/sinks_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/sinks_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "inplace"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 35: all_pairs_parallel scc engine graph with sinks and sources with 3 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/sinks_graph.txt",
+            7,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/sinks_graph.txt",
+                "--nThreads",
+                "3",
+                "--engine",
+                "scc"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 36: all_pairs_parallel scc engine 1TH vertices, 50 edges graph with 4 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/1TH_vertices_50_edges_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/1TH_vertices_50_edges_graph.txt",
+                "--nThreads",
+                "4",
+                "--engine",
+                "scc"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 37: all_pairs_parallel dial engine negative weight DAG with 2 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/negative_dag.txt",
+            5,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/negative_dag.txt",
+                "--nThreads",
+                "2",
+                "--engine",
+                "dial"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 38: all_pairs_parallel copy engine graph with sinks and sources with 4 threads, checkpoints every pivot and resume",
+            "all_pairs_parallel",
+            "./tests/test_outputs/sinks_graph.txt",
+            9,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/sinks_graph.txt",
+                "--nThreads",
+                "4",
+                "--checkpointFile",
+                "./tests/parallel_test_38.ckpt",
+                "--checkpointInterval",
+                "1",
+                "--resume"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 39: all_pairs_parallel inplace engine graph with sinks and sources with 3 threads, checkpoints every pivot and resume",
+            "all_pairs_parallel",
+            "./tests/test_outputs/sinks_graph.txt",
+            8,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/sinks_graph.txt",
+                "--nThreads",
+                "3",
+                "--engine",
+                "inplace",
+                "--checkpointFile",
+                "./tests/parallel_test_39.ckpt",
+                "--checkpointInterval",
+                "1",
+                "--resume"
+            ],
+            is_integration=True,
+            show_output=False
+        ),
+        TestCase(
+            "Parallel Test 40: all_pairs_parallel auto engine negative weight DAG with 2 threads",
+            "all_pairs_parallel",
+            "./tests/test_outputs/negative_dag.txt",
+            6,
+            args=[
+                "--inputFile",
+                "./tests/test_inputs/negative_dag.txt",
+                "--nThreads",
+                "2",
+                "--engine",
+                "auto"
+            ],
+            is_integration=True,
+            show_output=False
         )
     ]
     